@@ -1,4 +1,6 @@
 #include <Windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
 
 #include <unordered_map>
 
@@ -27,7 +29,50 @@
 #define DEFAULT_QUANTITY    (1ull << 4)
 #define DEFAULT_GRANULARITY (4096ull)
 
+#define DEFAULT_ARENA_RESERVATION (1ull << 36)
+#define DEFAULT_ARENA_GRANULARITY (1ull << 21)
+#define DEFAULT_ARENA_QUANTITY    (1ull << 0)
+
+/* a row of more than FLOOD_DEPTH keys and this many times the average row is
+   taken for flooding. */
+#define DEFAULT_TOLERANCE (2ll)
+#define FLOOD_DEPTH       (1ll << 7)
+
+/* keys longer than this are kept out of their rows, in blobs, which are
+   carved a cache line at least so that small thresholds cannot carve slots
+   too narrow for the pool's free list or misalign its pages. */
+#define DEFAULT_THRESHOLD (1ll << 8)
+#define MIN_BLOB_SIZE     (1ll << 6)
+
+/* keys up to this size are hashed and compared from a single vector register
+   by tables of the word hashes. */
+#define SHORT_KEY_SIZE (1ll << 6)
+
+/* bytes of the next row that cursors prefetch on entering a row. */
+#define PREFETCH_EXTENT (1ull << 9)
+
+#define MAX_THREADS (1ll << 6)
+
+/* average keys per bucket of a frozen table, the pilots tried for a bucket
+   before the freeze starts over with a new seed, and the seeds tried before
+   it gives up. */
+#define FROZEN_LOAD     (1ll << 2)
+#define FROZEN_ATTEMPTS (1ll << 20)
+#define FROZEN_SEEDS    (1ll << 4)
+
+/* bits of a frozen slot that hold the offset of its record; the rest hold a
+   fingerprint of its key. */
+#define FROZEN_OFFSET_BITS (48ll)
+
+/* pilots tried for a bucket of a static table before the build gives up. */
+#define STATIC_ATTEMPTS (1ll << 16)
+
+/* rows of a fresh key set, and the bytes of a row, one cache line. */
+#define DEFAULT_SET_QUANTITY (1ll << 4)
+#define SET_ROW_SIZE         (64ull)
+
 typedef unsigned long long Size, Address, U64;
+typedef unsigned int U32;
 typedef signed long long Count, Index;
 typedef int Boolean;
 typedef char Byte;
@@ -97,36 +142,404 @@ static inline void *AllocateMemory(Size size)
 	return result;
 }
 
+static inline void DecommitMemory(void *address, Size size)
+{
+	Assert(VirtualFree(address, size, MEM_DECOMMIT));
+}
+
+static inline void ReleaseMemory(void *address)
+{
+	Assert(VirtualFree(address, 0, MEM_RELEASE));
+}
+
 #define Copy memcpy
-#define Test memcmp
 #define Fill memset
 
-#define Hash(k, n) XXH3_64bits(k, n)
+static inline U64 LoadWord(const Byte *data)
+{
+	U64 word;
+	Copy(&word, data, sizeof(word));
+	return word;
+}
+
+static inline U32 LoadHalf(const Byte *data)
+{
+	U32 half;
+	Copy(&half, data, sizeof(half));
+	return half;
+}
+
+static inline Boolean TestVectors(const Byte *left, const Byte *right)
+{
+	__m256i difference = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)left), _mm256_loadu_si256((const __m256i *)right));
+	return !_mm256_testz_si256(difference, difference);
+}
+
+/* beyond 64 bytes: four vectors a step, of 64 bytes where AVX-512 is built
+   in, then single ones and a last vector that overlaps the one before it,
+   folded into one test. */
+static Boolean TestStream(const Byte *left, const Byte *right, Size size)
+{
+	Size i = 0;
+#if defined(__AVX512BW__) && defined(__AVX512VL__)
+	for (; i + 256 <= size; i += 256) {
+		__m512i difference = _mm512_or_si512(
+			_mm512_or_si512(
+				_mm512_xor_si512(_mm512_loadu_si512(left + i),       _mm512_loadu_si512(right + i)),
+				_mm512_xor_si512(_mm512_loadu_si512(left + i + 64),  _mm512_loadu_si512(right + i + 64))),
+			_mm512_or_si512(
+				_mm512_xor_si512(_mm512_loadu_si512(left + i + 128), _mm512_loadu_si512(right + i + 128)),
+				_mm512_xor_si512(_mm512_loadu_si512(left + i + 192), _mm512_loadu_si512(right + i + 192))));
+		if (_mm512_test_epi64_mask(difference, difference)) return 1;
+	}
+#endif
+	for (; i + 128 <= size; i += 128) {
+		__m256i difference = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(left + i)),      _mm256_loadu_si256((const __m256i *)(right + i))),
+				_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(left + i + 32)), _mm256_loadu_si256((const __m256i *)(right + i + 32)))),
+			_mm256_or_si256(
+				_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(left + i + 64)), _mm256_loadu_si256((const __m256i *)(right + i + 64))),
+				_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(left + i + 96)), _mm256_loadu_si256((const __m256i *)(right + i + 96)))));
+		if (!_mm256_testz_si256(difference, difference)) return 1;
+	}
+	__m256i difference = _mm256_setzero_si256();
+	for (; i + 32 <= size; i += 32)
+		difference = _mm256_or_si256(difference, _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(left + i)), _mm256_loadu_si256((const __m256i *)(right + i))));
+	difference = _mm256_or_si256(difference, _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(left + size - 32)), _mm256_loadu_si256((const __m256i *)(right + size - 32))));
+	return !_mm256_testz_si256(difference, difference);
+}
+
+/* nonzero if the `size` bytes at `left` and `right` differ, as memcmp is
+   tested against 0. no load leaves either range, since a key may end at the
+   last committed byte of a row: sizes under 32 take a masked load, or two
+   overlapping words, and longer ones whole vectors of which the last
+   overlaps. */
+static inline Boolean Test(const void *left, const void *right, Size size)
+{
+	const Byte *l = (const Byte *)left;
+	const Byte *r = (const Byte *)right;
+	if (size >= 32) {
+		if (size > 64) return TestStream(l, r, size);
+		return TestVectors(l, r) | TestVectors(l + size - 32, r + size - 32);
+	}
+#if defined(__AVX512BW__) && defined(__AVX512VL__)
+	/* masked bytes are not read, and cannot fault. */
+	__mmask32 mask = _bzhi_u32(~0u, (U32)size);
+	return _mm256_mask_cmpneq_epi8_mask(mask, _mm256_maskz_loadu_epi8(mask, l), _mm256_maskz_loadu_epi8(mask, r)) != 0;
+#else
+	if (size >= 16) {
+		__m128i head = _mm_xor_si128(_mm_loadu_si128((const __m128i *)l), _mm_loadu_si128((const __m128i *)r));
+		__m128i tail = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(l + size - 16)), _mm_loadu_si128((const __m128i *)(r + size - 16)));
+		__m128i difference = _mm_or_si128(head, tail);
+		return !_mm_testz_si128(difference, difference);
+	}
+	if (size >= 8) return ((LoadWord(l) ^ LoadWord(r)) | (LoadWord(l + size - 8) ^ LoadWord(r + size - 8))) != 0;
+	if (size >= 4) return ((LoadHalf(l) ^ LoadHalf(r)) | (LoadHalf(l + size - 4) ^ LoadHalf(r + size - 4))) != 0;
+	if (size)      return ((l[0] ^ r[0]) | (l[size >> 1] ^ r[size >> 1]) | (l[size - 1] ^ r[size - 1])) != 0;
+	return 0;
+#endif
+}
+
+static inline void Prefetch(Address address, Size size)
+{
+	for (Size i = 0; i < size; i += 64)
+		_mm_prefetch((const char *)(address + i), _MM_HINT_T0);
+}
+
+static inline U64 Random(void)
+{
+	U64 random;
+	while (!_rdrand64_step(&random));
+	return random;
+}
+
+/* the hashes a table may address its keys by, picked per table: XXH3, the
+   default and the choice for long keys, or for integers and short keys CRC32C
+   in hardware or a multiply-shift mixer. those two take a key as 8-byte
+   words, the last padded with zeros, after a start that folds in the length
+   and the seed, so they can be streamed. every table hashes under its own
+   seed, so that keys cannot be crafted to collide without it. snapshots,
+   checkpoints and shared segments record the hash of their table. callers
+   that know the hash of a table when they are compiled name it to Fetch<H>
+   and HashKey<H>, which then hash without dispatching on it. */
+typedef enum {
+	TableHash_XXH3,
+	TableHash_CRC32C,
+	TableHash_Multiply,
+	TableHash_Count,
+} TableHash;
+
+/* the `size` < 8 bytes at `at` in the low bytes of a word, the rest 0. the
+   loads overlap, not to read past the key. */
+static inline U64 LoadTail(const Byte *at, Size size)
+{
+	const unsigned char *bytes = (const unsigned char *)at;
+	if (size >= 4) return LoadHalf(at) | (U64)LoadHalf(at + size - 4) << ((size - 4) << 3);
+	if (size)      return bytes[0] | (U64)bytes[size >> 1] << ((size >> 1) << 3) | (U64)bytes[size - 1] << ((size - 1) << 3);
+	return 0;
+}
+
+template <U64 (*Start)(Size, U64), U64 (*Step)(U64, U64), U64 (*End)(U64)>
+static inline U64 HashWords(const void *key, Size size, U64 seed)
+{
+	const Byte *at    = (const Byte *)key;
+	U64         state = Start(size, seed);
+	for (Size i = size >> 3; i; --i, at += 8) state = Step(state, LoadWord(at));
+	if (size & 7) state = Step(state, LoadTail(at, size & 7));
+	return End(state);
+}
+
+/* two CRC32C lanes, the high one over the words times an odd constant: CRC
+   is linear, and a second lane over the words themselves would only repeat
+   the first. */
+static inline U64 StartCRC32C(Size size, U64 seed)
+{
+	return (U32)(seed ^ size) | (U64)(U32)(seed >> 32 ^ ~size) << 32;
+}
+
+static inline U64 StepCRC32C(U64 state, U64 word)
+{
+	return _mm_crc32_u64((U32)state, word) | _mm_crc32_u64(state >> 32, word * 0x9e3779b97f4a7c15ull) << 32;
+}
+
+static inline U64 EndCRC32C(U64 state)
+{
+	return state;
+}
+
+/* each step is a bijection of the state, so keys of a length up to 8 bytes
+   never collide. */
+static inline U64 StartMultiply(Size size, U64 seed)
+{
+	return (seed ^ size) * 0x9e3779b97f4a7c15ull;
+}
+
+static inline U64 StepMultiply(U64 state, U64 word)
+{
+	state = (state ^ word) * 0xbf58476d1ce4e5b9ull;
+	return state ^ state >> 32;
+}
+
+static inline U64 EndMultiply(U64 state)
+{
+	state *= 0x94d049bb133111ebull;
+	return state ^ state >> 29;
+}
+
+#if defined(__AVX512BW__)
+/* HashWords over a key of up to 8 words held in `words`, its bytes past
+   `size` zero: the lanes are the words HashWords would load. */
+template <U64 (*Start)(Size, U64), U64 (*Step)(U64, U64), U64 (*End)(U64)>
+static inline U64 HashLanes(__m512i words, Size size, U64 seed)
+{
+	U64 state = Start(size, seed);
+	for (Size i = (size + 7) >> 3; i; --i) {
+		state = Step(state, _mm_cvtsi128_si64(_mm512_castsi512_si128(words)));
+		words = _mm512_alignr_epi64(words, words, 1);
+	}
+	return End(state);
+}
+#endif
+
+static inline U64 HashXXH3(const void *key, Size size, U64 seed)
+{
+	return XXH3_64bits_withSeed(key, size, seed);
+}
+
+static inline U64 HashCRC32C(const void *key, Size size, U64 seed)
+{
+	return HashWords<StartCRC32C, StepCRC32C, EndCRC32C>(key, size, seed);
+}
+
+static inline U64 HashMultiply(const void *key, Size size, U64 seed)
+{
+	return HashWords<StartMultiply, StepMultiply, EndMultiply>(key, size, seed);
+}
+
+template <TableHash H>
+static inline U64 Hash(const void *key, Size size, U64 seed)
+{
+	if constexpr (H == TableHash_CRC32C)   return HashCRC32C(key, size, seed);
+	if constexpr (H == TableHash_Multiply) return HashMultiply(key, size, seed);
+	if constexpr (H == TableHash_XXH3)     return HashXXH3(key, size, seed);
+}
+
+static inline U64 Hash(TableHash hash, const void *key, Size size, U64 seed)
+{
+	switch (hash) {
+	case TableHash_CRC32C:   return Hash<TableHash_CRC32C>(key, size, seed);
+	case TableHash_Multiply: return Hash<TableHash_Multiply>(key, size, seed);
+	default:                 return Hash<TableHash_XXH3>(key, size, seed);
+	}
+}
+
+/* keys hashed together, one to a lane of a 512-bit vector. */
+#define HASH_BATCH (8ll)
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__)
+/* XXH3_64bits_withSeed of 8 keys in the lanes of a vector. lanes of 4 to 128
+   bytes are hashed in place, each size class under its mask, with gathers
+   that stay within the key; the rest are left for the caller. */
+static inline U64 GetSecret(Size offset)
+{
+	return LoadWord((const Byte *)XXH3_kSecret + offset);
+}
+
+/* the low and high halves of the 128-bit products, xored. */
+static inline __m512i MultiplyFold(__m512i left, __m512i right)
+{
+	__m512i half  = _mm512_set1_epi64(0xFFFFFFFFull);
+	__m512i lefth = _mm512_srli_epi64(left, 32);
+	__m512i righth = _mm512_srli_epi64(right, 32);
+	__m512i ll    = _mm512_mul_epu32(left, right);
+	__m512i lh    = _mm512_mul_epu32(left, righth);
+	__m512i hl    = _mm512_mul_epu32(lefth, right);
+	__m512i hh    = _mm512_mul_epu32(lefth, righth);
+	__m512i mid   = _mm512_add_epi64(_mm512_add_epi64(_mm512_srli_epi64(ll, 32), _mm512_and_si512(lh, half)), _mm512_and_si512(hl, half));
+	__m512i low   = _mm512_or_si512(_mm512_and_si512(ll, half), _mm512_slli_epi64(mid, 32));
+	__m512i high  = _mm512_add_epi64(_mm512_add_epi64(hh, _mm512_srli_epi64(lh, 32)), _mm512_add_epi64(_mm512_srli_epi64(hl, 32), _mm512_srli_epi64(mid, 32)));
+	return _mm512_xor_si512(low, high);
+}
+
+static inline __m512i Avalanche(__m512i hash)
+{
+	hash = _mm512_xor_si512(hash, _mm512_srli_epi64(hash, 37));
+	hash = _mm512_mullo_epi64(hash, _mm512_set1_epi64(PRIME_MX1));
+	return _mm512_xor_si512(hash, _mm512_srli_epi64(hash, 32));
+}
+
+static inline __m512i Gather(__mmask8 mask, __m512i addresses, Size offset)
+{
+	return _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), mask, _mm512_add_epi64(addresses, _mm512_set1_epi64(offset)), (const void *)0, 1);
+}
+
+/* XXH3_mix16B of each lane's 16 bytes at `at`, with the secret at `offset`. */
+static inline __m512i MixLanes(__mmask8 mask, __m512i at, Size offset, U64 seed)
+{
+	return MultiplyFold(_mm512_xor_si512(Gather(mask, at, 0), _mm512_set1_epi64(GetSecret(offset) + seed)),
+	                    _mm512_xor_si512(Gather(mask, at, 8), _mm512_set1_epi64(GetSecret(offset + 8) - seed)));
+}
+
+static __mmask8 HashLanes(Byte **keys, Count *sizes, U64 seed, U64 *hashes)
+{
+	__m512i addresses = _mm512_loadu_si512(keys);
+	__m512i lengths   = _mm512_loadu_si512(sizes);
+	__m512i hashed    = _mm512_setzero_si512();
+	__mmask8 short4   = _mm512_cmpge_epu64_mask(lengths, _mm512_set1_epi64(4))  & _mm512_cmple_epu64_mask(lengths, _mm512_set1_epi64(8));
+	__mmask8 short9   = _mm512_cmpge_epu64_mask(lengths, _mm512_set1_epi64(9))  & _mm512_cmple_epu64_mask(lengths, _mm512_set1_epi64(16));
+	__mmask8 middle   = _mm512_cmpge_epu64_mask(lengths, _mm512_set1_epi64(17)) & _mm512_cmple_epu64_mask(lengths, _mm512_set1_epi64(128));
+
+	if (short4) {
+		__m512i ends  = _mm512_sub_epi64(_mm512_add_epi64(addresses, lengths), _mm512_set1_epi64(4));
+		__m512i first = _mm512_cvtepu32_epi64(_mm512_mask_i64gather_epi32(_mm256_setzero_si256(), short4, addresses, (const void *)0, 1));
+		__m512i last  = _mm512_cvtepu32_epi64(_mm512_mask_i64gather_epi32(_mm256_setzero_si256(), short4, ends, (const void *)0, 1));
+		U64     fold  = seed ^ (U64)(U32)_bswap((int)seed) << 32;
+		__m512i hash  = _mm512_xor_si512(_mm512_add_epi64(last, _mm512_slli_epi64(first, 32)), _mm512_set1_epi64((GetSecret(8) ^ GetSecret(16)) - fold));
+		hash = _mm512_xor_si512(hash, _mm512_xor_si512(_mm512_rol_epi64(hash, 49), _mm512_rol_epi64(hash, 24)));
+		hash = _mm512_mullo_epi64(hash, _mm512_set1_epi64(PRIME_MX2));
+		hash = _mm512_xor_si512(hash, _mm512_add_epi64(_mm512_srli_epi64(hash, 35), lengths));
+		hash = _mm512_mullo_epi64(hash, _mm512_set1_epi64(PRIME_MX2));
+		hash = _mm512_xor_si512(hash, _mm512_srli_epi64(hash, 28));
+		hashed = _mm512_mask_mov_epi64(hashed, short4, hash);
+	}
+	if (short9) {
+		__m512i ends  = _mm512_sub_epi64(_mm512_add_epi64(addresses, lengths), _mm512_set1_epi64(8));
+		__m512i low   = _mm512_xor_si512(Gather(short9, addresses, 0), _mm512_set1_epi64((GetSecret(24) ^ GetSecret(32)) + seed));
+		__m512i high  = _mm512_xor_si512(Gather(short9, ends, 0),      _mm512_set1_epi64((GetSecret(40) ^ GetSecret(48)) - seed));
+		__m512i swap  = _mm512_set_epi8(
+			56, 57, 58, 59, 60, 61, 62, 63, 48, 49, 50, 51, 52, 53, 54, 55,
+			40, 41, 42, 43, 44, 45, 46, 47, 32, 33, 34, 35, 36, 37, 38, 39,
+			24, 25, 26, 27, 28, 29, 30, 31, 16, 17, 18, 19, 20, 21, 22, 23,
+			 8,  9, 10, 11, 12, 13, 14, 15,  0,  1,  2,  3,  4,  5,  6,  7);
+		__m512i hash  = _mm512_add_epi64(_mm512_add_epi64(lengths, _mm512_shuffle_epi8(low, swap)), _mm512_add_epi64(high, MultiplyFold(low, high)));
+		hashed = _mm512_mask_mov_epi64(hashed, short9, Avalanche(hash));
+	}
+	if (middle) {
+		__m512i  ends = _mm512_add_epi64(addresses, lengths);
+		__m512i  hash = _mm512_mullo_epi64(lengths, _mm512_set1_epi64(XXH_PRIME64_1));
+		__mmask8 mask = middle;
+		/* the rounds of XXH3_len_17to128_64b, from the innermost out. */
+		for (Size round = 0; round < 4 && mask; ++round) {
+			hash = _mm512_mask_add_epi64(hash, mask, hash, MixLanes(mask, _mm512_add_epi64(addresses, _mm512_set1_epi64(round * 16)), round * 32, seed));
+			hash = _mm512_mask_add_epi64(hash, mask, hash, MixLanes(mask, _mm512_sub_epi64(ends, _mm512_set1_epi64((round + 1) * 16)), round * 32 + 16, seed));
+			mask &= _mm512_cmpgt_epu64_mask(lengths, _mm512_set1_epi64((round + 1) * 32));
+		}
+		hashed = _mm512_mask_mov_epi64(hashed, middle, Avalanche(hash));
+	}
+	_mm512_storeu_si512(hashes, hashed);
+	return short4 | short9 | middle;
+}
+#endif
+
+/* Hash of `keyscnt` keys under `hash` and `seed` into `hashes`, with the
+   same values; XXH3 is taken in lanes. */
+void HashBatch(Byte **keys, Count *sizes, Count keyscnt, TableHash hash, U64 seed, U64 *hashes)
+{
+	Count i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__)
+	if (hash == TableHash_XXH3)
+		for (; i + HASH_BATCH <= keyscnt; i += HASH_BATCH)
+			for (U32 rest = ~HashLanes(keys + i, sizes + i, seed, hashes + i) & 0xFF; rest; rest &= rest - 1) {
+				Count j = i + _tzcnt_u32(rest);
+				hashes[j] = HashXXH3(keys[j], sizes[j], seed);
+			}
+#endif
+	for (; i < keyscnt; ++i) hashes[i] = Hash(hash, keys[i], sizes[i], seed);
+}
+
+/* mixes a hash with a table's seed once more before it picks a row, so that
+   the row bits are spread even where a hash is weak in its low bits. */
+static inline constexpr U64 Scatter(U64 hash, U64 seed)
+{
+	hash ^= seed;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
 
 typedef struct {
 	Size    extent;
 	Address address;
 	Size    quantity;
 	Size    granularity;
+	Count   depth;
+	U64     seed;
+	TableHash hash;
+	Boolean owned;
 } Table0;
 
 void Initialize0(Table0 *table) {
+	/* memory the caller hands in is only ever cleared, never decommitted. */
+	table->owned = !table->address;
 	if (!table->extent     ) table->extent      = DEFAULT_EXTENT;
 	if (!table->address    ) table->address     = (Address)AllocateMemory(table->extent);
 	if (!table->quantity   ) table->quantity    = DEFAULT_QUANTITY;
 	if (!table->granularity) table->granularity = DEFAULT_GRANULARITY;
+	if (!table->seed       ) table->seed        = Random();
 	Fill((void *)table->address, 0, table->extent);
 	Assert(CheckAlignment(table->quantity));
 	Assert(CheckAlignment(table->granularity));
+	table->depth = 0;
 }
 
-Index *Fetch0(void *key, Count keysz, Table0 *table) {
+/* the hash of a key in `table`, for Fetch0Hashed on it or on any table of the
+   same seed. */
+U64 HashKey0(Table0 *table, void *key, Count keysz)
+{
+	return Hash(table->hash, key, keysz, table->seed);
+}
+
+Index *Fetch0Hashed(void *key, Count keysz, U64 keyhash, Table0 *table) {
 	Index *result = 0;
 
 	Count linescnt = table->quantity;
 	Count linesz = table->granularity;
 	
-	Index hash = Hash(key, keysz) & (linescnt - 1);
+	Index hash = Scatter(keyhash, table->seed) & (linescnt - 1);
 	Address addr = table->address + (hash << _tzcnt_u64(linesz));
 	Address addrend = table->address + table->extent;
 	Address lineaddr = addr;
@@ -186,32 +599,313 @@ enter:
 	}
 	addr = AlignForwards(addr + inc, ALIGNOF(Index));
 	if (addr > lineaddr + linesz - sizeof(Index)) addr = lineaddr += layersz;
+	if (lineaddr - table->address >= table->depth * layersz)
+		table->depth = ((lineaddr - table->address) >> _tzcnt_u64(layersz)) + 1;
 	result = (Index *)addr;
 	return result;
 }
 
+Index *Fetch0(void *key, Count keysz, Table0 *table) {
+	return Fetch0Hashed(key, keysz, HashKey0(table, key, keysz), table);
+}
+
+/* clears the lines of the first layer that were entered and hands the deeper
+   layers back to the system, which returns them zeroed on the next touch. */
+void Reset0(Table0 *table)
+{
+	Count linescnt = table->quantity;
+	Count linesz = table->granularity;
+	Count layersz = linescnt << _tzcnt_u64(linesz);
+
+	if (!table->depth) return;
+	for (Count i = 0; i < linescnt; ++i) {
+		Address lineaddr = table->address + (i << _tzcnt_u64(linesz));
+		if (*(Count *)lineaddr) Fill((void *)lineaddr, 0, linesz);
+	}
+	if (table->depth > 1) {
+		Size size = (table->depth - 1) * layersz;
+		if (table->owned) {
+			DecommitMemory((void *)(table->address + layersz), size);
+			CommitMemory((void *)(table->address + layersz), size);
+		} else
+			Fill((void *)(table->address + layersz), 0, size);
+	}
+	table->depth = 0;
+}
+
+void Destroy0(Table0 *table)
+{
+	if (table->owned) ReleaseMemory((void *)table->address);
+	table->address = 0;
+	table->depth = 0;
+	table->seed = 0;
+}
+
+/* walks every key of a Table0; keys split across layers are reassembled into
+   `buffer`, others are pointed at in place. */
+typedef struct {
+	Table0 *table;
+	Count   line;
+	Address addr;
+	Address lineaddr;
+	Byte   *key;
+	Count   keysz;
+	Byte   *buffer;
+	Size    buffersz;
+} Table0Cursor;
+
+void Begin0(Table0Cursor *cursor, Table0 *table)
+{
+	cursor->table    = table;
+	cursor->line     = -1;
+	cursor->addr     = 0;
+	cursor->lineaddr = 0;
+	cursor->key      = 0;
+	cursor->keysz    = 0;
+	cursor->buffer   = 0;
+	cursor->buffersz = 0;
+}
+
+void End0(Table0Cursor *cursor)
+{
+	if (cursor->buffer) ReleaseMemory(cursor->buffer);
+	cursor->buffer   = 0;
+	cursor->buffersz = 0;
+}
+
+Index *Advance0(Table0Cursor *cursor)
+{
+	Table0 *table = cursor->table;
+	Count linescnt = table->quantity;
+	Count linesz = table->granularity;
+	Count layersz = linescnt << _tzcnt_u64(linesz);
+
+	Address addr = cursor->addr;
+	Address lineaddr = cursor->lineaddr;
+	Count remsz, remlinesz, inc;
+
+	for (;;) {
+		if (addr) {
+			remsz = *(Count *)addr;
+			if (remsz) break;
+		}
+		if (++cursor->line >= linescnt) {
+			cursor->addr = 0;
+			return 0;
+		}
+		addr = lineaddr = table->address + (cursor->line << _tzcnt_u64(linesz));
+		if (cursor->line + 1 < linescnt) Prefetch(addr + linesz, PREFETCH_EXTENT);
+	}
+
+	addr += sizeof(Count);
+	remlinesz = linesz - (addr - lineaddr);
+	cursor->keysz = remsz;
+	if (remsz <= remlinesz) {
+		cursor->key = (Byte *)addr;
+		inc = remsz;
+	} else {
+		if (cursor->buffersz < (Size)remsz) {
+			if (cursor->buffer) ReleaseMemory(cursor->buffer);
+			cursor->buffersz = AlignForwards(remsz, GetPageSize());
+			cursor->buffer   = (Byte *)AllocateMemory(cursor->buffersz);
+		}
+		Byte *ptr = cursor->buffer;
+		for (;;) {
+			inc = remsz <= remlinesz ? remsz : remlinesz;
+			Copy(ptr, (void *)addr, inc);
+			ptr += inc;
+			remsz -= inc;
+			if (!remsz) break;
+			addr = lineaddr += layersz;
+			remlinesz = linesz;
+		}
+		cursor->key = cursor->buffer;
+	}
+	addr = AlignForwards(addr + inc, ALIGNOF(Index));
+	if (addr > lineaddr + linesz - sizeof(Index)) addr = lineaddr += layersz;
+	Index *index = (Index *)addr;
+	addr += sizeof(Index);
+	if (addr > lineaddr + linesz - sizeof(Count)) addr = lineaddr += layersz;
+
+	cursor->addr     = addr;
+	cursor->lineaddr = lineaddr;
+	return index;
+}
+
 /*****************************************************************/
 
+/* one reservation from which many small tables are carved. slots are powers of
+   two, committed in steps of `granularity`, and recycled through a list per
+   size so that creating a table is a pointer bump. */
+typedef struct {
+	Size    reservation;
+	Size    granularity;
+	Address address;
+	Size    commission;
+	Size    extent;
+	Address vacancies[64];
+} TableArena;
+
+void InitializeArena(TableArena *arena)
+{
+	Size pagesz = GetPageSize();
+
+	if (!arena->reservation) arena->reservation = DEFAULT_ARENA_RESERVATION;
+	arena->reservation = AlignForwards(arena->reservation, pagesz);
+
+	if (!arena->granularity) arena->granularity = DEFAULT_ARENA_GRANULARITY;
+	arena->granularity = AlignForwards(arena->granularity, pagesz);
+
+	if (!arena->address) arena->address = (Address)ReserveMemory(arena->reservation);
+	arena->commission = 0;
+	arena->extent     = 0;
+	Fill(arena->vacancies, 0, sizeof(arena->vacancies));
+
+	Assert(CheckAlignment(arena->granularity));
+}
+
+void DestroyArena(TableArena *arena)
+{
+	ReleaseMemory((void *)arena->address);
+	arena->address = 0;
+}
+
+/* returns a zeroed, committed slot of `size` bytes, or 0 if the arena is spent. */
+static void *Carve(TableArena *arena, Size size)
+{
+	Assert(CheckAlignment(size));
+	Address *vacancy = &arena->vacancies[_tzcnt_u64(size)];
+	Address address = *vacancy;
+	if (address) {
+		*vacancy = *(Address *)address;
+		*(Address *)address = 0;
+		return (void *)address;
+	}
+	if (arena->extent + size > arena->reservation) return 0;
+	address = arena->address + arena->extent;
+	arena->extent += size;
+	if (arena->extent > arena->commission) {
+		Size commission = AlignForwards(arena->extent - arena->commission, arena->granularity);
+		if (arena->commission + commission > arena->reservation) commission = arena->reservation - arena->commission;
+		CommitMemory((void *)(arena->address + arena->commission), commission);
+		arena->commission += commission;
+	}
+	return (void *)address;
+}
+
+/* the slot must be zeroed by the caller. */
+static void Vacate(TableArena *arena, void *address, Size size)
+{
+	Address *vacancy = &arena->vacancies[_tzcnt_u64(size)];
+	*(Address *)address = *vacancy;
+	*vacancy = (Address)address;
+}
+
 typedef struct {
 	Count size;
 	Byte  data[];
 	/* Index index;*/
 } TableKey;
 
+/* a key over the threshold of its table is stored in a blob carved from the
+   pool, and its record holds this in place of the bytes, with BLOB_FLAG set
+   in its size; scans compare sizes first, so they pass blob records within
+   a line. snapshots, checkpoints and frozen tables fold blobs back in. */
+#define BLOB_FLAG (1ll << 62)
+
+typedef struct {
+	U64     strhash;
+	Address data;
+} TableBlob;
+
+/* a key of size -1 ends the row and continues it in the page at `overflow`.
+   `dirty` is set on the first row of a chain when it changes, until the next
+   checkpoint. `filter` holds the filter bits of every key of the chain, so
+   that most misses are told from the header alone. */
 typedef struct {
 	Size     commission;
 	Size     extent;
+	Address  overflow;
+	Boolean  dirty;
+	U32      filter;
 	TableKey keys[];
 } TableRow;
 
+/* two bits of a 32-bit bloom filter, from the top of the raw hash; the row
+   index is taken from the scattered one. */
+static inline U32 GetFilterBits(U64 strhash)
+{
+	return 1u << (strhash >> 59) | 1u << (strhash >> 54 & 31);
+}
+
+static inline Boolean TestFilter(TableRow *row, U32 bits)
+{
+	return (row->filter & bits) == bits;
+}
+
+typedef struct TableImage TableImage;
+
 typedef struct {
 	Size    reservation;
 	Size    granularity;
 	Count   quantity;
 	Address address;
 	Size    width;
+	TableArena *arena;
+	Count   spillage;
+	U64     seed;
+	TableHash hash;
+	Count   tolerance;
+	Count   population;
+	Boolean interning;
+	Address symbols;
+	Size    symbolssz;
+	Address view;
+	Boolean sealed;
+	const char *backing;
+	TableImage *image;
+	Boolean shared;
+	Count   threshold;
+	Count   blobs;
 } Table;
 
+/* overflow pages, blobs and reverse arrays of tables without an arena are
+   carved from this one. tables on different threads share it, so it is taken
+   under a lock, which the caller releases with ReleaseSpillArena. */
+static volatile LONG64 spilling;
+
+static TableArena *TakeSpillArena(void)
+{
+	static TableArena arena;
+	while (InterlockedCompareExchange64(&spilling, 1, 0)) YieldProcessor();
+	if (!arena.address) InitializeArena(&arena);
+	return &arena;
+}
+
+static inline void ReleaseSpillArena(void)
+{
+	InterlockedExchange64(&spilling, 0);
+}
+
+/* Carve and Vacate on the arena of `table`, or else on the spill arena. */
+static void *CarvePool(Table *table, Size size)
+{
+	if (table->arena) return Carve(table->arena, size);
+	void *address = Carve(TakeSpillArena(), size);
+	ReleaseSpillArena();
+	return address;
+}
+
+static void VacatePool(Table *table, void *address, Size size)
+{
+	if (table->arena) {
+		Vacate(table->arena, address, size);
+		return;
+	}
+	Vacate(TakeSpillArena(), address, size);
+	ReleaseSpillArena();
+}
+
 static inline Size GetTableWidth(Table *table)
 {
 	Size breadth = AlignBackwards(table->reservation >> _tzcnt_u64(table->quantity), GetPageSize());
@@ -220,27 +914,76 @@ static inline Size GetTableWidth(Table *table)
 
 static_assert(alignof(Index) == sizeof(Count), "");
 
+/* maps a sparse scratch file in the directory `backing` over the whole
+   reservation, so that rows are paged to the file rather than held in memory.
+   the file is deleted once the view is unmapped. */
+static Address MapBacking(Table *table)
+{
+	char path[MAX_PATH];
+	if (!GetTempFileNameA(table->backing, "tbl", 0, path)) return 0;
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, 0);
+	if (file == INVALID_HANDLE_VALUE) return 0;
+	DWORD returned;
+	DeviceIoControl(file, FSCTL_SET_SPARSE, 0, 0, 0, 0, &returned, 0);
+	HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READWRITE, (DWORD)(table->reservation >> 32), (DWORD)table->reservation, 0);
+	CloseHandle(file);
+	if (!mapping) return 0;
+	void *view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, table->reservation);
+	CloseHandle(mapping);
+	return (Address)view;
+}
+
+/* pages of a mapped table are committed by its file, which grows as they are
+   first written; shared segments are reserved and commit as memory does. */
+static inline void CommitRow(Table *table, void *address, Size size)
+{
+	if (!table->view || table->shared) CommitMemory(address, size);
+}
+
 void Initialize(Table *table)
 {
 	Size pagesz = GetPageSize();
 
-	if (!table->reservation) table->reservation = DEFAULT_RESERVATION;
-	table->reservation = AlignForwards(table->reservation, pagesz);
-
 	if (!table->granularity) table->granularity = DEFAULT_GRANULARITY;
 	table->granularity = AlignForwards(table->granularity, pagesz);
 
-	if (!table->quantity) table->quantity = DEFAULT_QUANTITY;
+	if (!table->quantity) table->quantity = table->arena ? DEFAULT_ARENA_QUANTITY : DEFAULT_QUANTITY;
+
+	/* carved tables start with rows of a single granule and grow by doubling. */
+	if (!table->reservation) table->reservation = table->arena ? table->quantity * table->granularity : DEFAULT_RESERVATION;
+	table->reservation = AlignForwards(table->reservation, pagesz);
+
+	if (!table->seed) table->seed = Random();
 
-	if (!table->address) table->address = (Address)ReserveMemory(table->reservation);
+	/* a negative tolerance disables the flooding guard, and a negative
+	   threshold blobs. */
+	if (!table->tolerance) table->tolerance = DEFAULT_TOLERANCE;
+	if (!table->threshold) table->threshold = DEFAULT_THRESHOLD;
+
+	if (!table->address) {
+		if      (table->arena)   table->address = (Address)Carve(table->arena, table->reservation);
+		else if (table->backing) table->address = table->view = MapBacking(table);
+		else                     table->address = (Address)ReserveMemory(table->reservation);
+		Assert(table->address);
+	}
 
 	table->width = GetTableWidth(table);
 	for (Count i = 0; i < table->quantity; ++i) {
 		TableRow *row = (TableRow *)(table->address + i * table->width);
-		CommitMemory((void *)row, table->granularity);
-		row->commission = table->granularity;
-		row->extent     = sizeof(TableRow);
+		if (table->arena) {
+			row->commission = table->width;
+		} else {
+			CommitRow(table, (void *)row, table->granularity);
+			row->commission = table->granularity;
+		}
+		row->extent   = sizeof(TableRow);
+		row->overflow = 0;
+		row->dirty    = 0;
+		row->filter   = 0;
 	}
+	table->spillage   = 0;
+	table->population = 0;
+	table->blobs      = 0;
 
 	Assert(CheckAlignment(table->reservation));
 	Assert(CheckAlignment(table->granularity));
@@ -248,145 +991,3826 @@ void Initialize(Table *table)
 	Assert(CheckAlignment(table->width));
 }
 
+/* the bytes a key takes in its record. */
+static inline Count GetKeyBreadth(TableKey *key)
+{
+	return key->size & BLOB_FLAG ? sizeof(TableBlob) : key->size;
+}
+
+static inline Count GetKeySize(TableKey *key)
+{
+	return key->size & ~BLOB_FLAG;
+}
+
+static inline Byte *GetKeyData(TableKey *key)
+{
+	return key->size & BLOB_FLAG ? (Byte *)((TableBlob *)key->data)->data : key->data;
+}
+
 static inline Index *GetKeyIndex(TableKey *key)
 {
-	Index *index = (Index *)AlignForwards((Address)key + sizeof(TableKey) + key->size, alignof(Index));
+	Index *index = (Index *)AlignForwards((Address)key + sizeof(TableKey) + GetKeyBreadth(key), alignof(Index));
 	return index;
 }
 
 static inline TableKey *GetNextKey(TableKey *key)
 {
-	TableKey *next = (TableKey *)(AlignForwards((Address)key + sizeof(TableKey) + key->size, alignof(Index)) + sizeof(Index));
+	TableKey *next = (TableKey *)(AlignForwards((Address)key + sizeof(TableKey) + GetKeyBreadth(key), alignof(Index)) + sizeof(Index));
 	return next;
 }
 
-typedef enum {
-	TableMode_Access,
-	TableMode_Insert,
-} TableMode;
+static inline Size GetBlobSize(Count strsz)
+{
+	Size size = MIN_BLOB_SIZE;
+	while (size < (Size)strsz) size <<= 1;
+	return size;
+}
+
+static inline Boolean TestBlob(TableKey *key, Byte *str, Count strsz, U64 strhash)
+{
+	TableBlob *blob = (TableBlob *)key->data;
+	return blob->strhash == strhash && !Test((Byte *)blob->data, str, strsz);
+}
+
+/* the record `key` with its blob folded in. */
+static inline Size GaugeKey(TableKey *key)
+{
+	return AlignForwards(sizeof(TableKey) + GetKeySize(key), alignof(Index)) + sizeof(Index);
+}
+
+static void FoldKey(TableKey *key, TableKey *folded)
+{
+	Count strsz = GetKeySize(key);
+	folded->size = strsz;
+	Copy(folded->data, GetKeyData(key), strsz);
+	Fill(folded->data + strsz, 0, GaugeKey(key) - sizeof(TableKey) - sizeof(Index) - strsz);
+	*GetKeyIndex(folded) = *GetKeyIndex(key);
+}
+
+/* an insert under TableMode_Guard is of a key the table hashed itself, and
+   may reseed the table against flooding; one under TableMode_Insert came with
+   the caller's hash, which a reseed would leave stale, and never does. */
+typedef enum {
+	TableMode_Access,
+	TableMode_Insert,
+	TableMode_Guard,
+} TableMode;
+
+static Boolean Rebuild(Table *table, Count quantity, U64 seed);
+static void Preserve(Table *table, Count beginning, Count count);
+
+/* links a page from the pool behind `row`, large enough for `addition`. */
+static TableRow *Spill(TableRow *row, Size addition, Table *table)
+{
+	Size size = table->granularity;
+	while (size < sizeof(TableRow) + addition + sizeof(TableKey)) size <<= 1;
+	TableRow *page = (TableRow *)CarvePool(table, size);
+	if (!page) return 0;
+	page->commission = size;
+	page->extent     = sizeof(TableRow);
+	((TableKey *)((Address)row + row->extent))->size = -1;
+	row->overflow = (Address)page;
+	++table->spillage;
+	return page;
+}
+
+static inline Count GetRowIndex(U64 strhash, Table *table)
+{
+	return Scatter(strhash, table->seed) & (table->quantity - 1);
+}
+
+static inline TableRow *GetRow(U64 strhash, Table *table)
+{
+	return (TableRow *)(table->address + (GetRowIndex(strhash, table) << _tzcnt_u64(table->width)));
+}
+
+/* the terminating key of the row, at the extent of its last overflow page. */
+static TableKey *GetRowEnd(TableRow **row)
+{
+	while ((*row)->overflow) *row = (TableRow *)(*row)->overflow;
+	return (TableKey *)((Address)*row + (*row)->extent);
+}
+
+/* the keys of the row and its overflow pages. */
+static Count GetRowDepth(TableRow *row)
+{
+	Count depth = 0;
+	for (TableKey *key = row->keys; key->size;) {
+		if (key->size < 0) {
+			row = (TableRow *)row->overflow;
+			key = row->keys;
+			continue;
+		}
+		key = GetNextKey(key);
+		++depth;
+	}
+	return depth;
+}
+
+/* makes room in the reverse array for the id of one more interned key; the
+   array doubles through the table's pool as it fills. it grows before the key
+   is entered, so that no failure leaves a key in a row without an id. */
+static Boolean Enlist(Table *table)
+{
+	if ((table->population + 1) * sizeof(TableKey *) > table->symbolssz) {
+		Size symbolssz = table->symbolssz ? table->symbolssz << 1 : table->granularity;
+		Address symbols = (Address)CarvePool(table, symbolssz);
+		if (!symbols) return 0;
+		if (table->symbols) {
+			Copy((void *)symbols, (void *)table->symbols, table->symbolssz);
+			Fill((void *)table->symbols, 0, table->symbolssz);
+			VacatePool(table, (void *)table->symbols, table->symbolssz);
+		}
+		table->symbols   = symbols;
+		table->symbolssz = symbolssz;
+	}
+	return 1;
+}
+
+/* the flooding guard, after an insert's scan passed `depth` keys of a row:
+   rebuilds the table under a new seed if the row is too long for chance. the
+   missing key must then be hashed again, under the new seed. */
+static Boolean Reseed(Count depth, Table *table)
+{
+	if (table->sealed || table->tolerance <= 0 || depth <= FLOOD_DEPTH
+	 || depth <= (table->population >> _tzcnt_u64(table->quantity)) * table->tolerance)
+		return 0;
+	if (!Rebuild(table, table->quantity, Random())) return 0;
+	/* keys that share a row under any seed are not told apart by another one,
+	   so the guard stands down instead of rebuilding on every insert into that
+	   row. */
+	Count longest = 0;
+	for (Count i = 0; i < table->quantity; ++i) {
+		Count length = GetRowDepth((TableRow *)(table->address + i * table->width));
+		if (length > longest) longest = length;
+	}
+	if (longest >= depth) table->tolerance = -table->tolerance;
+	return 1;
+}
+
+/* makes room for a key of `strsz` bytes at `key`, the end of `row`. returns
+   the entered key for the caller to fill at GetKeyData, or 0 if no memory is
+   left. */
+static TableKey *Enter(TableRow *row, TableKey *key, Count strsz, U64 strhash, Table *table)
+{
+	Size    addition, breadth;
+	Boolean blob;
+
+	if (table->sealed) return 0;
+	if (table->interning && !Enlist(table)) return 0;
+	if (table->image) Preserve(table, GetRowIndex(strhash, table), 1);
+	blob     = table->threshold > 0 && strsz > table->threshold;
+	breadth  = blob ? sizeof(TableBlob) : strsz;
+	addition = breadth + GetForwardAligner((Address)key + sizeof(TableKey) + breadth, alignof(Index)) + sizeof(Index) + sizeof(TableKey);
+	if (row->extent + addition + sizeof(TableKey) > row->commission) {
+		Size    commission = AlignForwards(addition, table->granularity);
+		Boolean primary    = (Address)row - table->address < table->reservation;
+		if (primary && row->commission + commission <= table->width) {
+			CommitRow(table, (void *)((Address)row + row->commission), commission);
+			row->commission += commission;
+		} else {
+			/* pages carved in one process would not be mapped in the others. */
+			if (table->shared) return 0;
+			/* carved tables rather double once they average a page of spill per row. */
+			if (table->arena && table->spillage >= table->quantity && Rebuild(table, table->quantity << 1, table->seed))
+				goto rebuilt;
+			row = Spill(row, addition, table);
+			if (!row) return 0;
+			key = row->keys;
+		}
+	}
+	if (blob) {
+		TableBlob *stub = (TableBlob *)key->data;
+		stub->data = (Address)CarvePool(table, GetBlobSize(strsz));
+		if (!stub->data) return 0;
+		stub->strhash = strhash;
+		++table->blobs;
+	}
+	row->extent += addition;
+	if (table->shared) InterlockedExchangeAdd64((volatile LONG64 *)&table->population, 1);
+	else               ++table->population;
+	key->size = blob ? strsz | BLOB_FLAG : strsz;
+	if (table->interning) {
+		((TableKey **)table->symbols)[table->population - 1] = key;
+		*GetKeyIndex(key) = table->population - 1;
+	}
+	row = GetRow(strhash, table);
+	row->dirty   = 1;
+	row->filter |= GetFilterBits(strhash);
+	return key;
+rebuilt:
+	row = GetRow(strhash, table);
+	key = GetRowEnd(&row);
+	return Enter(row, key, strsz, strhash, table);
+}
+
+/* the hash a key is addressed by in `table` as it is now; a reseed under
+   flooding draws a new seed, after which the key is hashed again. */
+static inline U64 GetKeyHash(Table *table, void *key, Count keysz)
+{
+	return Hash(table->hash, key, keysz, table->seed);
+}
+
+/* the hash a key is addressed by in `table`; callers may compute it once per
+   key and hand it to the `Hashed` fetches of this table and of every table of
+   the same hash and seed. those never reseed; and so that a Fetch on the table
+   cannot reseed it under the hashes a caller holds either, its flooding guard
+   is turned off. tables that must keep the guard are reached through Fetch
+   alone. */
+U64 HashKey(Table *table, void *key, Count keysz)
+{
+	if (table->tolerance > 0) table->tolerance = -table->tolerance;
+	return GetKeyHash(table, key, keysz);
+}
+
+/* HashKey on a table of the hash `H`. */
+template <TableHash H>
+U64 HashKey(Table *table, void *key, Count keysz)
+{
+	Assert(table->hash == H);
+	if (table->tolerance > 0) table->tolerance = -table->tolerance;
+	return Hash<H>(key, keysz, table->seed);
+}
+
+static inline Index *SeekHashed(Byte *str, Count strsz, U64 strhash, TableMode mode, Table *table)
+{
+	TableRow *row    = GetRow(strhash, table);
+	TableKey *key    = row->keys;
+	Count     depth  = 0;
+	Count     blobsz = table->threshold > 0 && strsz > table->threshold ? strsz | BLOB_FLAG : 0;
+
+	/* a miss the filter rules out skips the scan, and the flooding guard with
+	   it; rows long enough to flood saturate their filters. */
+	if (!TestFilter(row, GetFilterBits(strhash))) {
+		key = GetRowEnd(&row);
+		goto failure;
+	}
+	for (;;) {
+		if (key->size > 0) {
+			if (key->size == strsz && !Test(key->data, str, strsz))
+				goto success;
+			if (key->size == blobsz && TestBlob(key, str, strsz, strhash))
+				goto success;
+			key = GetNextKey(key);
+			++depth;
+		} else if (key->size) {
+			row = (TableRow *)row->overflow;
+			key = row->keys;
+		} else
+			goto failure;
+	}
+
+failure:
+	if (mode == TableMode_Access) return 0;
+	if (mode == TableMode_Guard && Reseed(depth, table)) return SeekHashed(str, strsz, GetKeyHash(table, str, strsz), mode, table);
+	key = Enter(row, key, strsz, strhash, table);
+	if (!key) return 0;
+	Copy(GetKeyData(key), str, strsz);
+success:
+	Index *index = GetKeyIndex(key);
+	return index;
+}
+
+Index *FetchHashed(Byte *str, Count strsz, U64 strhash, Table *table)
+{
+	return SeekHashed(str, strsz, strhash, TableMode_Insert, table);
+}
+
+/* FetchHashed without the insert: 0 if `str` is absent. */
+Index *FindHashed(Byte *str, Count strsz, U64 strhash, Table *table)
+{
+	return SeekHashed(str, strsz, strhash, TableMode_Access, table);
+}
+
+#if defined(__AVX512BW__)
+/* Fetch of a key of up to SHORT_KEY_SIZE bytes on a table of a word hash
+   `H`, which loads the key once under a mask: the hash is taken from the
+   lanes of that register, candidates are compared against it and a missing
+   key is stored from it. */
+template <TableHash H>
+static Index *FetchShort(Byte *str, Count strsz, Table *table)
+{
+	__mmask64 mask    = _bzhi_u64(~0ull, (U32)strsz);
+	__m512i   query   = _mm512_maskz_loadu_epi8(mask, str);
+	U64       strhash = H == TableHash_CRC32C ? HashLanes<StartCRC32C, StepCRC32C, EndCRC32C>(query, strsz, table->seed)
+	                                          : HashLanes<StartMultiply, StepMultiply, EndMultiply>(query, strsz, table->seed);
+	TableRow *row     = GetRow(strhash, table);
+	TableKey *key     = row->keys;
+	Count     depth   = 0;
+
+	if (!TestFilter(row, GetFilterBits(strhash))) {
+		key = GetRowEnd(&row);
+		goto failure;
+	}
+	for (;;) {
+		if (key->size > 0) {
+			if (key->size == strsz && !_mm512_mask_cmpneq_epi8_mask(mask, _mm512_maskz_loadu_epi8(mask, key->data), query))
+				goto success;
+			key = GetNextKey(key);
+			++depth;
+		} else if (key->size) {
+			row = (TableRow *)row->overflow;
+			key = row->keys;
+		} else
+			goto failure;
+	}
+
+failure:
+	if (Reseed(depth, table)) return FetchShort<H>(str, strsz, table);
+	key = Enter(row, key, strsz, strhash, table);
+	if (!key) return 0;
+	_mm512_mask_storeu_epi8(GetKeyData(key), mask, query);
+success:
+	return GetKeyIndex(key);
+}
+#endif
+
+/* Fetch on a table of the hash `H`. */
+template <TableHash H>
+Index *Fetch(Byte *str, Count strsz, Table *table)
+{
+	Assert(table->hash == H);
+#if defined(__AVX512BW__)
+	if (H != TableHash_XXH3 && strsz <= SHORT_KEY_SIZE && !(table->threshold > 0 && strsz > table->threshold))
+		return FetchShort<H>(str, strsz, table);
+#endif
+	return SeekHashed(str, strsz, Hash<H>(str, strsz, table->seed), TableMode_Guard, table);
+}
+
+Index *Fetch(Byte *str, Count strsz, Table *table)
+{
+	switch (table->hash) {
+	case TableHash_CRC32C:   return Fetch<TableHash_CRC32C>(str, strsz, table);
+	case TableHash_Multiply: return Fetch<TableHash_Multiply>(str, strsz, table);
+	default:                 return Fetch<TableHash_XXH3>(str, strsz, table);
+	}
+}
+
+/* the slots of `keyscnt` keys in `indices`, 0 for absent ones. keys are
+   hashed HASH_BATCH at a time and their rows prefetched before the scans. */
+void FindBatch(Byte **keys, Count *sizes, Count keyscnt, Index **indices, Table *table)
+{
+	for (Count i = 0; i < keyscnt; i += HASH_BATCH) {
+		U64   strhashes[HASH_BATCH];
+		Count count = keyscnt - i < HASH_BATCH ? keyscnt - i : HASH_BATCH;
+		HashBatch(keys + i, sizes + i, count, table->hash, table->seed, strhashes);
+		for (Count j = 0; j < count; ++j) _mm_prefetch((const char *)GetRow(strhashes[j], table), _MM_HINT_T0);
+		for (Count j = 0; j < count; ++j) indices[i + j] = FindHashed(keys[i + j], sizes[i + j], strhashes[j], table);
+	}
+}
+
+/* Fetch and a write of `value`, which marks the row for the next checkpoint;
+   writes through the index Fetch returns are not tracked. refused on
+   interning tables, whose indices are the ids of their keys. */
+Boolean Store(Byte *str, Count strsz, Index value, Table *table)
+{
+	if (table->interning) return 0;
+	U64    strhash = GetKeyHash(table, str, strsz);
+	if (table->image) Preserve(table, GetRowIndex(strhash, table), 1);
+	U64    seed    = table->seed;
+	Index *index   = SeekHashed(str, strsz, strhash, TableMode_Guard, table);
+	if (!index) return 0;
+	*index = value;
+	/* a reseed in the fetch left every row it filled dirty. */
+	if (table->seed == seed) GetRow(strhash, table)->dirty = 1;
+	return 1;
+}
+
+/* one piece of a key gathered from several buffers. */
+typedef struct {
+	void *data;
+	Count size;
+} KeyPiece;
+
+/* HashWords over the concatenated pieces; words that straddle pieces are
+   gathered in `carry`. */
+template <U64 (*Start)(Size, U64), U64 (*Step)(U64, U64), U64 (*End)(U64)>
+static U64 HashPieceWords(KeyPiece *pieces, Count piecescnt, U64 seed)
+{
+	Count strsz = 0;
+	for (Count i = 0; i < piecescnt; ++i) strsz += pieces[i].size;
+	U64   state   = Start(strsz, seed);
+	Byte  carry[8];
+	Count carried = 0;
+	for (Count i = 0; i < piecescnt; ++i) {
+		const Byte *at   = (const Byte *)pieces[i].data;
+		Count       left = pieces[i].size;
+		for (; carried && left; --left) {
+			carry[carried++] = *at++;
+			if (carried == 8) {
+				state   = Step(state, LoadWord(carry));
+				carried = 0;
+			}
+		}
+		for (; left >= 8; left -= 8, at += 8) state = Step(state, LoadWord(at));
+		for (; left; --left) carry[carried++] = *at++;
+	}
+	if (carried) state = Step(state, LoadTail(carry, carried));
+	return End(state);
+}
+
+/* equals HashKey over the concatenated pieces, for a table of `hash` and
+   `seed`. */
+U64 HashPieces(KeyPiece *pieces, Count piecescnt, TableHash hash, U64 seed)
+{
+	switch (hash) {
+	case TableHash_CRC32C:   return HashPieceWords<StartCRC32C, StepCRC32C, EndCRC32C>(pieces, piecescnt, seed);
+	case TableHash_Multiply: return HashPieceWords<StartMultiply, StepMultiply, EndMultiply>(pieces, piecescnt, seed);
+	default:                 break;
+	}
+	XXH3_state_t state;
+	XXH3_64bits_reset_withSeed(&state, seed);
+	for (Count i = 0; i < piecescnt; ++i)
+		XXH3_64bits_update(&state, pieces[i].data, pieces[i].size);
+	return XXH3_64bits_digest(&state);
+}
+
+static inline Boolean TestPieces(Byte *data, KeyPiece *pieces, Count piecescnt)
+{
+	for (Count i = 0; i < piecescnt; ++i) {
+		if (Test(data, pieces[i].data, pieces[i].size)) return 0;
+		data += pieces[i].size;
+	}
+	return 1;
+}
+
+/* Fetch on the concatenation of the pieces, without concatenating them. */
+Index *FetchPieces(KeyPiece *pieces, Count piecescnt, Table *table)
+{
+	Count strsz = 0;
+	for (Count i = 0; i < piecescnt; ++i) strsz += pieces[i].size;
+
+	U64       strhash = HashPieces(pieces, piecescnt, table->hash, table->seed);
+	TableRow *row     = GetRow(strhash, table);
+	TableKey *key     = row->keys;
+	Count     depth   = 0;
+	Count     blobsz  = table->threshold > 0 && strsz > table->threshold ? strsz | BLOB_FLAG : 0;
+
+	if (!TestFilter(row, GetFilterBits(strhash))) {
+		key = GetRowEnd(&row);
+		goto failure;
+	}
+	for (;;) {
+		if (key->size > 0) {
+			if (key->size == strsz && TestPieces(key->data, pieces, piecescnt))
+				goto success;
+			if (key->size == blobsz && ((TableBlob *)key->data)->strhash == strhash && TestPieces(GetKeyData(key), pieces, piecescnt))
+				goto success;
+			key = GetNextKey(key);
+			++depth;
+		} else if (key->size) {
+			row = (TableRow *)row->overflow;
+			key = row->keys;
+		} else
+			goto failure;
+	}
+
+failure:
+	if (Reseed(depth, table)) return FetchPieces(pieces, piecescnt, table);
+	key = Enter(row, key, strsz, strhash, table);
+	if (!key) return 0;
+	strsz = 0;
+	for (Count i = 0; i < piecescnt; ++i) {
+		Copy(GetKeyData(key) + strsz, pieces[i].data, pieces[i].size);
+		strsz += pieces[i].size;
+	}
+success:
+	Index *index = GetKeyIndex(key);
+	return index;
+}
+
+/* only rows with entries are cleared; pages committed past the first granule
+   are decommitted so a reset table has the footprint of a fresh one. */
+void Reset(Table *table)
+{
+	/* the rows of a sealed table are a read-only view. */
+	Assert(!table->sealed);
+	if (table->image) Preserve(table, 0, table->quantity);
+	for (Count i = 0; i < table->quantity; ++i) {
+		TableRow *row = (TableRow *)(table->address + i * table->width);
+		if (row->extent == sizeof(TableRow)) continue;
+		for (TableRow *page = row; table->blobs && page; page = (TableRow *)page->overflow)
+			for (TableKey *key = page->keys; key->size > 0; key = GetNextKey(key)) {
+				if (!(key->size & BLOB_FLAG)) continue;
+				Size size = GetBlobSize(GetKeySize(key));
+				Fill(GetKeyData(key), 0, size);
+				VacatePool(table, GetKeyData(key), size);
+			}
+		for (TableRow *page = (TableRow *)row->overflow, *next; page; page = next) {
+			next = (TableRow *)page->overflow;
+			Size size = page->commission;
+			Fill(page, 0, page->extent + sizeof(TableKey));
+			VacatePool(table, page, size);
+		}
+		row->overflow = 0;
+		/* rows of a mapped table are file pages and are cleared in full instead. */
+		if (!table->view && row->commission > table->granularity) {
+			DecommitMemory((void *)((Address)row + table->granularity), row->commission - table->granularity);
+			row->commission = table->granularity;
+		}
+		Size extent = row->extent + sizeof(TableKey);
+		if (!table->view && extent > table->granularity) extent = table->granularity;
+		Fill(row->keys, 0, extent - sizeof(TableRow));
+		row->extent = sizeof(TableRow);
+		row->dirty  = 1;
+		row->filter = 0;
+	}
+	table->spillage   = 0;
+	table->population = 0;
+	table->blobs      = 0;
+}
+
+void Destroy(Table *table)
+{
+	if (table->image) Preserve(table, 0, table->quantity);
+	if (table->symbols) {
+		Fill((void *)table->symbols, 0, table->symbolssz);
+		VacatePool(table, (void *)table->symbols, table->symbolssz);
+		table->symbols   = 0;
+		table->symbolssz = 0;
+	}
+	if (table->view) {
+		if (table->spillage || table->blobs) Reset(table);
+		UnmapViewOfFile((void *)table->view);
+		table->view = 0;
+	} else if (table->arena) {
+		Reset(table);
+		Vacate(table->arena, (void *)table->address, table->reservation);
+	} else {
+		if (table->spillage || table->blobs) Reset(table);
+		ReleaseMemory((void *)table->address);
+	}
+	table->address = 0;
+	table->width   = 0;
+	table->seed    = 0;
+}
+
+/* moves the entries into a table of `quantity` rows hashed with `seed`; carved
+   tables double through here, and flooded ones are reseeded. indices returned
+   before the move are invalidated. */
+static Boolean Rebuild(Table *table, Count quantity, U64 seed)
+{
+	Table rebuilt = {};
+	Size  breadth = table->reservation >> _tzcnt_u64(table->quantity);
+	/* rows of a loaded table can be narrower than a granule. */
+	if (breadth < table->granularity) breadth = table->granularity;
+	rebuilt.reservation = breadth << _tzcnt_u64(quantity);
+	rebuilt.granularity = table->granularity;
+	rebuilt.quantity    = quantity;
+	rebuilt.arena       = table->arena;
+	rebuilt.seed        = seed;
+	rebuilt.hash        = table->hash;
+	/* the guard is off for the moves, so that a long row cannot set off a
+	   rebuild within this one. */
+	rebuilt.tolerance   = -1;
+	rebuilt.backing     = table->backing;
+	rebuilt.threshold   = table->threshold;
+	if (rebuilt.arena) {
+		rebuilt.address = (Address)Carve(rebuilt.arena, rebuilt.reservation);
+		if (!rebuilt.address) return 0;
+	}
+	Initialize(&rebuilt);
+
+	for (Count i = 0; i < table->quantity; ++i) {
+		TableRow *row = (TableRow *)(table->address + i * table->width);
+		for (TableKey *key = row->keys; key->size;) {
+			if (key->size < 0) {
+				row = (TableRow *)row->overflow;
+				key = row->keys;
+				continue;
+			}
+			Index *index = Fetch(GetKeyData(key), GetKeySize(key), &rebuilt);
+			if (!index) {
+				Destroy(&rebuilt);
+				return 0;
+			}
+			*index = *GetKeyIndex(key);
+			key = GetNextKey(key);
+		}
+	}
+	rebuilt.tolerance = table->tolerance;
+
+	/* interned ids are carried over above; the reverse array then follows the keys. */
+	if (table->interning) {
+		for (Count i = 0; i < rebuilt.quantity; ++i) {
+			TableRow *row = (TableRow *)(rebuilt.address + i * rebuilt.width);
+			for (TableKey *key = row->keys; key->size;) {
+				if (key->size < 0) {
+					row = (TableRow *)row->overflow;
+					key = row->keys;
+					continue;
+				}
+				((TableKey **)table->symbols)[*GetKeyIndex(key)] = key;
+				key = GetNextKey(key);
+			}
+		}
+		rebuilt.interning = 1;
+		rebuilt.symbols   = table->symbols;
+		rebuilt.symbolssz = table->symbolssz;
+		table->symbols    = 0;
+	}
+
+	Destroy(table);
+	*table = rebuilt;
+	return 1;
+}
+
+/* in interning mode, the id of the key, given on its first insert; the slot
+   Fetch returns holds the same id and must not be written. */
+Index Intern(Byte *str, Count strsz, Table *table)
+{
+	Index *index = Fetch(str, strsz, table);
+	return index ? *index : -1;
+}
+
+/* the stored key of an interned id, without a copy; its bytes are at
+   GetKeyData. */
+TableKey *GetSymbol(Index id, Table *table)
+{
+	Assert(id >= 0 && id < table->population);
+	return ((TableKey **)table->symbols)[id];
+}
+
+/* walks every key of a Table in place, row by row and through overflow pages. */
+typedef struct {
+	Table    *table;
+	Count     row;
+	TableRow *page;
+	TableKey *next;
+	Byte     *key;
+	Count     keysz;
+} TableCursor;
+
+void Begin(TableCursor *cursor, Table *table)
+{
+	cursor->table = table;
+	cursor->row   = -1;
+	cursor->page  = 0;
+	cursor->next  = 0;
+	cursor->key   = 0;
+	cursor->keysz = 0;
+}
+
+Index *Advance(TableCursor *cursor)
+{
+	Table    *table = cursor->table;
+	TableKey *key   = cursor->next;
+
+	for (;;) {
+		if (key) {
+			if (key->size > 0) break;
+			if (key->size < 0) {
+				cursor->page = (TableRow *)cursor->page->overflow;
+				key = cursor->page->keys;
+				continue;
+			}
+		}
+		if (++cursor->row >= table->quantity) {
+			cursor->next = 0;
+			return 0;
+		}
+		cursor->page = (TableRow *)(table->address + cursor->row * table->width);
+		if (cursor->row + 1 < table->quantity) Prefetch((Address)cursor->page + table->width, PREFETCH_EXTENT);
+		key = cursor->page->keys;
+	}
+
+	cursor->key   = GetKeyData(key);
+	cursor->keysz = GetKeySize(key);
+	cursor->next  = GetNextKey(key);
+	return GetKeyIndex(key);
+}
+
+/*****************************************************************/
+
+/* threads parked on a semaphore each between jobs; the calling thread runs as
+   worker 0, so a pool of one thread has no background threads. */
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*Job)(Count worker, void *context);
+
+typedef struct {
+	ThreadPool *pool;
+	Count       worker;
+	HANDLE      thread;
+	HANDLE      start;
+} ThreadPoolWorker;
+
+struct ThreadPool {
+	Count            threadscnt;
+	HANDLE           finish;
+	Job              job;
+	void            *context;
+	Boolean          quitting;
+	ThreadPoolWorker workers[MAX_THREADS];
+};
+
+static DWORD WINAPI RunWorker(LPVOID parameter)
+{
+	ThreadPoolWorker *worker = (ThreadPoolWorker *)parameter;
+	ThreadPool       *pool   = worker->pool;
+	for (;;) {
+		WaitForSingleObject(worker->start, INFINITE);
+		if (pool->quitting) return 0;
+		pool->job(worker->worker, pool->context);
+		ReleaseSemaphore(pool->finish, 1, 0);
+	}
+}
+
+static inline Count GetProcessorsCount(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+
+void InitializePool(ThreadPool *pool)
+{
+	if (!pool->threadscnt) pool->threadscnt = GetProcessorsCount();
+	if (pool->threadscnt > MAX_THREADS) pool->threadscnt = MAX_THREADS;
+
+	pool->finish   = CreateSemaphore(0, 0, MAX_THREADS, 0);
+	pool->quitting = 0;
+	Assert(pool->finish);
+	for (Count i = 1; i < pool->threadscnt; ++i) {
+		ThreadPoolWorker *worker = &pool->workers[i];
+		worker->pool   = pool;
+		worker->worker = i;
+		worker->start  = CreateSemaphore(0, 0, 1, 0);
+		worker->thread = CreateThread(0, 0, RunWorker, worker, 0, 0);
+		Assert(worker->start && worker->thread);
+	}
+}
+
+void DestroyPool(ThreadPool *pool)
+{
+	pool->quitting = 1;
+	for (Count i = 1; i < pool->threadscnt; ++i)
+		ReleaseSemaphore(pool->workers[i].start, 1, 0);
+	for (Count i = 1; i < pool->threadscnt; ++i) {
+		WaitForSingleObject(pool->workers[i].thread, INFINITE);
+		CloseHandle(pool->workers[i].thread);
+		CloseHandle(pool->workers[i].start);
+	}
+	CloseHandle(pool->finish);
+}
+
+/* runs `job` on every worker and returns once all have. */
+void Run(ThreadPool *pool, Job job, void *context)
+{
+	pool->job     = job;
+	pool->context = context;
+	for (Count i = 1; i < pool->threadscnt; ++i)
+		ReleaseSemaphore(pool->workers[i].start, 1, 0);
+	job(0, context);
+	for (Count i = 1; i < pool->threadscnt; ++i)
+		WaitForSingleObject(pool->finish, INFINITE);
+}
+
+/* a worker's share of rows, [low half, high half), taken from the front by
+   its owner and split from the back by thieves; both sides move by CAS. */
+typedef struct {
+	alignas(64) volatile LONG64 range;
+} Stint;
+
+static inline LONG64 PackStint(Count beginning, Count ending)
+{
+	return (LONG64)((U64)ending << 32 | (U64)beginning);
+}
+
+static inline Boolean TakeRow(Stint *stint, Count *row)
+{
+	for (;;) {
+		LONG64 range     = stint->range;
+		Count  beginning = (U64)range & 0xFFFFFFFF;
+		Count  ending    = (U64)range >> 32;
+		if (beginning >= ending) return 0;
+		if (InterlockedCompareExchange64(&stint->range, PackStint(beginning + 1, ending), range) == range) {
+			*row = beginning;
+			return 1;
+		}
+	}
+}
+
+static inline Boolean StealRows(Stint *victim, Stint *stint)
+{
+	for (;;) {
+		LONG64 range     = victim->range;
+		Count  beginning = (U64)range & 0xFFFFFFFF;
+		Count  ending    = (U64)range >> 32;
+		if (beginning >= ending) return 0;
+		Count middle = beginning + ((ending - beginning) >> 1);
+		if (InterlockedCompareExchange64(&victim->range, PackStint(beginning, middle), range) == range) {
+			InterlockedExchange64(&stint->range, PackStint(middle, ending));
+			return 1;
+		}
+	}
+}
+
+typedef void (*TableVisitor)(Byte *key, Count keysz, Index *index, void *context);
+typedef U64  (*TableMapper)(Byte *key, Count keysz, Index *index, void *context);
+typedef U64  (*TableReducer)(U64 left, U64 right);
+
+typedef struct {
+	Table       *table;
+	Count        stintscnt;
+	Stint        stints[MAX_THREADS];
+	TableVisitor visit;
+	TableMapper  map;
+	TableReducer reduce;
+	void        *context;
+	struct {
+		alignas(64) U64 value;
+	} partials[MAX_THREADS];
+} TableScan;
+
+static void ScanRows(Count worker, void *context)
+{
+	TableScan *scan  = (TableScan *)context;
+	Table     *table = scan->table;
+	Stint     *stint = &scan->stints[worker];
+	U64        value = scan->partials[worker].value;
+
+	for (;;) {
+		Count i;
+		while (TakeRow(stint, &i)) {
+			TableRow *row = (TableRow *)(table->address + i * table->width);
+			for (TableKey *key = row->keys; key->size;) {
+				if (key->size < 0) {
+					row = (TableRow *)row->overflow;
+					key = row->keys;
+					continue;
+				}
+				if (scan->map) value = scan->reduce(value, scan->map(GetKeyData(key), GetKeySize(key), GetKeyIndex(key), scan->context));
+				else           scan->visit(GetKeyData(key), GetKeySize(key), GetKeyIndex(key), scan->context);
+				key = GetNextKey(key);
+			}
+		}
+		Boolean stolen = 0;
+		for (Count j = 1; j < scan->stintscnt && !stolen; ++j)
+			stolen = StealRows(&scan->stints[(worker + j) % scan->stintscnt], stint);
+		if (!stolen) break;
+	}
+	scan->partials[worker].value = value;
+}
+
+static void BeginScan(TableScan *scan, Table *table, ThreadPool *pool)
+{
+	scan->table     = table;
+	scan->stintscnt = pool->threadscnt;
+	for (Count i = 0; i < scan->stintscnt; ++i) {
+		Count beginning = table->quantity * i / scan->stintscnt;
+		Count ending    = table->quantity * (i + 1) / scan->stintscnt;
+		scan->stints[i].range = PackStint(beginning, ending);
+	}
+}
+
+/* calls `visit` on every entry from all workers of the pool; rows are visited
+   by one worker each, in no particular order. */
+void ForEach(Table *table, ThreadPool *pool, TableVisitor visit, void *context)
+{
+	TableScan scan = {};
+	BeginScan(&scan, table, pool);
+	scan.visit   = visit;
+	scan.context = context;
+	Run(pool, ScanRows, &scan);
+}
+
+/* folds `map` of every entry with `reduce`, which must be associative and
+   commutative, starting each worker from `identity`. */
+U64 Reduce(Table *table, ThreadPool *pool, TableMapper map, TableReducer reduce, U64 identity, void *context)
+{
+	TableScan scan = {};
+	BeginScan(&scan, table, pool);
+	scan.map     = map;
+	scan.reduce  = reduce;
+	scan.context = context;
+	for (Count i = 0; i < scan.stintscnt; ++i) scan.partials[i].value = identity;
+	Run(pool, ScanRows, &scan);
+
+	U64 value = identity;
+	for (Count i = 0; i < scan.stintscnt; ++i) value = reduce(value, scan.partials[i].value);
+	return value;
+}
+
+/* state of a bulk build: keys are hashed, then radix-partitioned by row into
+   `order`, where row r owns [offsets[r], offsets[r + 1]). */
+typedef struct {
+	Table   *table;
+	Byte   **keys;
+	Count   *sizes;
+	Index   *values;
+	Count    keyscnt;
+	Count    threadscnt;
+	U64     *rows;
+	U32     *filters;
+	Count   *histograms;
+	Count   *offsets;
+	Count   *order;
+	Boolean *deferrals;
+	Stint    stints[MAX_THREADS];
+	struct {
+		alignas(64) Count value;
+	} populations[MAX_THREADS];
+} TableBuild;
+
+static void HashKeys(Count worker, void *context)
+{
+	TableBuild *build     = (TableBuild *)context;
+	Table      *table     = build->table;
+	Count      *histogram = build->histograms + worker * table->quantity;
+	Count       beginning = build->keyscnt * worker / build->threadscnt;
+	Count       ending    = build->keyscnt * (worker + 1) / build->threadscnt;
+
+	Fill(histogram, 0, table->quantity * sizeof(Count));
+	for (Count i = beginning; i < ending; i += HASH_BATCH) {
+		U64   strhashes[HASH_BATCH];
+		Count count = ending - i < HASH_BATCH ? ending - i : HASH_BATCH;
+		HashBatch(build->keys + i, build->sizes + i, count, table->hash, table->seed, strhashes);
+		for (Count j = 0; j < count; ++j) {
+			U64 row = Scatter(strhashes[j], table->seed) & (table->quantity - 1);
+			build->rows[i + j]    = row;
+			build->filters[i + j] = GetFilterBits(strhashes[j]);
+			++histogram[row];
+		}
+	}
+}
+
+static void PartitionKeys(Count worker, void *context)
+{
+	TableBuild *build     = (TableBuild *)context;
+	Count      *histogram = build->histograms + worker * build->table->quantity;
+	Count       beginning = build->keyscnt * worker / build->threadscnt;
+	Count       ending    = build->keyscnt * (worker + 1) / build->threadscnt;
+
+	for (Count i = beginning; i < ending; ++i)
+		build->order[histogram[build->rows[i]]++] = i;
+}
+
+/* fills whole rows, committing each row once; rows that would outgrow the
+   table width or hold keys for blobs are deferred to Fetch. */
+static void FillRows(Count worker, void *context)
+{
+	TableBuild *build      = (TableBuild *)context;
+	Table      *table      = build->table;
+	Stint      *stint      = &build->stints[worker];
+	Count       population = 0;
+
+	for (;;) {
+		Count i;
+		while (TakeRow(stint, &i)) {
+			TableRow *row       = (TableRow *)(table->address + i * table->width);
+			Count     beginning = build->offsets[i];
+			Count     ending    = build->offsets[i + 1];
+			if (beginning == ending) continue;
+
+			Size    extent = row->extent + sizeof(TableKey);
+			Boolean blobs  = 0;
+			for (Count j = beginning; j < ending; ++j) {
+				Count strsz = build->sizes[build->order[j]];
+				extent += AlignForwards(sizeof(TableKey) + strsz, alignof(Index)) + sizeof(Index);
+				blobs  |= table->threshold > 0 && strsz > table->threshold;
+			}
+			if (row->overflow || extent > table->width || blobs) {
+				build->deferrals[i] = 1;
+				continue;
+			}
+			extent = AlignForwards(extent, table->granularity);
+			if (extent > row->commission) {
+				CommitRow(table, (void *)((Address)row + row->commission), extent - row->commission);
+				row->commission = extent;
+			}
+
+			for (Count j = beginning; j < ending; ++j) {
+				Count  k     = build->order[j];
+				Byte  *str   = build->keys[k];
+				Count  strsz = build->sizes[k];
+				Index  value = build->values ? build->values[k] : k;
+				TableKey *key = row->keys;
+				for (; key->size; key = GetNextKey(key))
+					if (key->size == strsz && !Test(key->data, str, strsz)) break;
+				if (!key->size) {
+					key->size = strsz;
+					Copy(key->data, str, strsz);
+					row->extent = (Address)GetNextKey(key) - (Address)row;
+					++population;
+				}
+				*GetKeyIndex(key) = value;
+				row->filter |= build->filters[k];
+			}
+			row->dirty = 1;
+		}
+		Boolean stolen = 0;
+		for (Count j = 1; j < build->threadscnt && !stolen; ++j)
+			stolen = StealRows(&build->stints[(worker + j) % build->threadscnt], stint);
+		if (!stolen) break;
+	}
+	build->populations[worker].value = population;
+}
+
+/* inserts `keyscnt` keys, with `values` or else their positions, using every
+   worker of the pool. a later duplicate overwrites the value of an earlier
+   one. interning tables are filled through Intern, so their keys take ids in
+   input order, and they take no `values`. returns 0 for those and for sealed
+   tables, or if no memory is left, with the keys before the failure inserted. */
+Boolean Build(Table *table, ThreadPool *pool, Byte **keys, Count *sizes, Index *values, Count keyscnt)
+{
+	if (table->sealed || (table->interning && values)) return 0;
+	if (table->image) Preserve(table, 0, table->quantity);
+	if (table->interning) {
+		for (Count i = 0; i < keyscnt; ++i)
+			if (Intern(keys[i], sizes[i], table) < 0) return 0;
+		return 1;
+	}
+
+	TableBuild build = {};
+	build.table      = table;
+	build.keys       = keys;
+	build.sizes      = sizes;
+	build.values     = values;
+	build.keyscnt    = keyscnt;
+	build.threadscnt = pool->threadscnt;
+
+	Size rowssz       = AlignForwards(keyscnt * sizeof(U64), GetPageSize());
+	Size filterssz    = AlignForwards(keyscnt * sizeof(U32), GetPageSize());
+	Size histogramssz = AlignForwards(build.threadscnt * table->quantity * sizeof(Count), GetPageSize());
+	Size offsetssz    = AlignForwards((table->quantity + 1) * sizeof(Count), GetPageSize());
+	Size ordersz      = AlignForwards(keyscnt * sizeof(Count), GetPageSize());
+	Size deferralssz  = AlignForwards(table->quantity * sizeof(Boolean), GetPageSize());
+	Address scratch   = (Address)AllocateMemory(rowssz + filterssz + histogramssz + offsetssz + ordersz + deferralssz);
+	build.rows       = (U64     *)(scratch);
+	build.filters    = (U32     *)(scratch + rowssz);
+	build.histograms = (Count   *)(scratch + rowssz + filterssz);
+	build.offsets    = (Count   *)(scratch + rowssz + filterssz + histogramssz);
+	build.order      = (Count   *)(scratch + rowssz + filterssz + histogramssz + offsetssz);
+	build.deferrals  = (Boolean *)(scratch + rowssz + filterssz + histogramssz + offsetssz + ordersz);
+
+	/* the flooding guard of Fetch, applied to the whole partition at once. */
+	for (Count attempt = 0;; ++attempt) {
+		Run(pool, HashKeys, &build);
+		Count offset = 0, longest = 0;
+		for (Count r = 0; r < table->quantity; ++r) {
+			build.offsets[r] = offset;
+			Count length = 0;
+			for (Count w = 0; w < build.threadscnt; ++w) {
+				Count *count = &build.histograms[w * table->quantity + r];
+				Count  added = *count;
+				*count  = offset;
+				offset += added;
+				length += added;
+			}
+			if (length > longest) longest = length;
+		}
+		build.offsets[table->quantity] = offset;
+
+		Count average = (table->population + keyscnt) >> _tzcnt_u64(table->quantity);
+		if (table->tolerance <= 0 || attempt >= 4 || longest <= FLOOD_DEPTH || longest <= average * table->tolerance) break;
+		/* a failed rebuild leaves the table as it was, and the partition
+		   above still holds for its seed. */
+		if (!table->population) table->seed = Random();
+		else if (!Rebuild(table, table->quantity, Random())) break;
+	}
+	Run(pool, PartitionKeys, &build);
+
+	for (Count i = 0; i < build.threadscnt; ++i) {
+		Count beginning = table->quantity * i / build.threadscnt;
+		Count ending    = table->quantity * (i + 1) / build.threadscnt;
+		build.stints[i].range = PackStint(beginning, ending);
+	}
+	Run(pool, FillRows, &build);
+	for (Count i = 0; i < build.threadscnt; ++i) table->population += build.populations[i].value;
+	Count quantity = table->quantity;
+
+	/* Fetch may rebuild the table from here on, so rows are counted as partitioned. */
+	for (Count r = 0; r < quantity; ++r) {
+		if (!build.deferrals[r]) continue;
+		for (Count j = build.offsets[r]; j < build.offsets[r + 1]; ++j) {
+			Count  k     = build.order[j];
+			Index *index = Fetch(keys[k], sizes[k], table);
+			if (!index) {
+				ReleaseMemory((void *)scratch);
+				return 0;
+			}
+			*index = values ? values[k] : k;
+		}
+	}
+
+	ReleaseMemory((void *)scratch);
+	return 1;
+}
+
+/*****************************************************************/
+
+/* an immutable table under a minimal perfect hash: a key's bucket picks a
+   pilot, and the pilot its position among `quantity` slots, each an offset
+   into `heap` of a record laid out as a TableKey and its index, under a
+   fingerprint of the key. pilots, slots and heap share one allocation. a
+   miss reads two lines, a pilot and a slot, unless the fingerprints match,
+   one time in 65536; a hit reads the record as well. */
+typedef struct {
+	Count    quantity;
+	Count    bucketscnt;
+	U64      seed;
+	Address  address;
+	Size     size;
+	U32     *pilots;
+	U64     *slots;
+	Address  heap;
+} FrozenTable;
+
+static inline U64 GetRange(U64 x, U64 n)
+{
+	return (U64)(((unsigned __int128)x * n) >> 64);
+}
+
+static inline U64 GetFrozenPosition(U64 scattered, U32 pilot, FrozenTable *frozen)
+{
+	return GetRange(Scatter(scattered + pilot, frozen->seed), frozen->quantity);
+}
+
+/* the low bits of the scattered hash, apart from the high ones that pick
+   the bucket. */
+static inline U64 GetFrozenPrint(U64 scattered)
+{
+	return scattered << FROZEN_OFFSET_BITS;
+}
+
+typedef struct {
+	TableKey *key;
+	U64       scattered;
+	U64       bucket;
+} FrozenKey;
+
+/* places every bucket, largest first; 0 if some bucket ran out of pilots. */
+static Boolean PlaceBuckets(FrozenTable *frozen, FrozenKey *keys, Count *firsts, Count *buckets, U64 *positions, U64 *taken)
+{
+	for (Count i = 0; i < frozen->bucketscnt; ++i) {
+		Count bucket    = buckets[i];
+		Count beginning = firsts[bucket];
+		Count ending    = firsts[bucket + 1];
+		if (beginning == ending) break;
+		U32 pilot = 0;
+		for (;; ++pilot) {
+			if (pilot >= FROZEN_ATTEMPTS) return 0;
+			Count j = beginning;
+			for (; j < ending; ++j) {
+				U64 position = GetFrozenPosition(keys[j].scattered, pilot, frozen);
+				if (taken[position >> 6] & (1ull << (position & 63))) break;
+				taken[position >> 6] |= 1ull << (position & 63);
+				positions[j] = position;
+			}
+			if (j == ending) break;
+			for (Count k = beginning; k < j; ++k)
+				taken[positions[k] >> 6] &= ~(1ull << (positions[k] & 63));
+		}
+		frozen->pilots[bucket] = pilot;
+	}
+	return 1;
+}
+
+void DestroyFrozen(FrozenTable *frozen)
+{
+	ReleaseMemory((void *)frozen->address);
+	frozen->address = 0;
+}
+
+/* whether two keys of a bucket scatter alike; every pilot sends them to the
+   same position, so no pilot can place the bucket. */
+static Boolean CheckScattered(FrozenKey *keys, Count *firsts, Count bucketscnt)
+{
+	for (Count b = 0; b < bucketscnt; ++b)
+		for (Count i = firsts[b]; i < firsts[b + 1]; ++i)
+			for (Count j = i + 1; j < firsts[b + 1]; ++j)
+				if (keys[i].scattered == keys[j].scattered) return 1;
+	return 0;
+}
+
+/* builds `frozen` from the entries of `table`, which is left as it is.
+   returns 0 if no seed of FROZEN_SEEDS placed every key. */
+Boolean Freeze(Table *table, FrozenTable *frozen)
+{
+	Count n = table->population;
+	frozen->quantity   = n;
+	frozen->bucketscnt = (n + FROZEN_LOAD - 1) / FROZEN_LOAD;
+	if (!frozen->bucketscnt) frozen->bucketscnt = 1;
+
+	Size keyssz      = AlignForwards(n * sizeof(FrozenKey), GetPageSize());
+	Size firstssz    = AlignForwards((frozen->bucketscnt + 1) * sizeof(Count), GetPageSize());
+	Size bucketssz   = AlignForwards((frozen->bucketscnt + 1) * sizeof(Count), GetPageSize());
+	Size positionssz = AlignForwards((n + 2) * sizeof(U64), GetPageSize());
+	Size takensz     = AlignForwards(((n + 63) >> 6) * sizeof(U64), GetPageSize());
+	Address scratch  = (Address)AllocateMemory(keyssz * 2 + firstssz + bucketssz + positionssz + takensz);
+	FrozenKey *unsorted  = (FrozenKey *)(scratch);
+	FrozenKey *keys      = (FrozenKey *)(scratch + keyssz);
+	Count     *firsts    = (Count     *)(scratch + keyssz * 2);
+	Count     *buckets   = (Count     *)(scratch + keyssz * 2 + firstssz);
+	U64       *positions = (U64       *)(scratch + keyssz * 2 + firstssz + bucketssz);
+	U64       *taken     = (U64       *)(scratch + keyssz * 2 + firstssz + bucketssz + positionssz);
+
+	Size  heapsz = 0;
+	Count k      = 0;
+	for (Count r = 0; r < table->quantity; ++r) {
+		TableRow *row = (TableRow *)(table->address + r * table->width);
+		for (TableKey *key = row->keys; key->size;) {
+			if (key->size < 0) {
+				row = (TableRow *)row->overflow;
+				key = row->keys;
+				continue;
+			}
+			unsorted[k++].key = key;
+			heapsz += GaugeKey(key);
+			key = GetNextKey(key);
+		}
+	}
+
+	Size pilotssz = AlignForwards(frozen->bucketscnt * sizeof(U32), alignof(U64));
+	Size slotssz  = n * sizeof(U64);
+	frozen->size    = AlignForwards(pilotssz + slotssz + heapsz + sizeof(TableKey), GetPageSize());
+	frozen->address = (Address)AllocateMemory(frozen->size);
+	frozen->pilots  = (U32 *)frozen->address;
+	frozen->slots   = (U64 *)(frozen->address + pilotssz);
+	frozen->heap    = frozen->address + pilotssz + slotssz;
+
+	Count seeds = 0;
+	for (;; ++seeds) {
+		if (seeds >= FROZEN_SEEDS) {
+			ReleaseMemory((void *)scratch);
+			DestroyFrozen(frozen);
+			return 0;
+		}
+		frozen->seed = Random();
+
+		/* keys grouped by bucket, and buckets ordered by size, both counting sorts. */
+		Fill(firsts, 0, (frozen->bucketscnt + 1) * sizeof(Count));
+		for (Count i = 0; i < n; ++i) {
+			TableKey *key = unsorted[i].key;
+			unsorted[i].scattered = Scatter(HashXXH3(GetKeyData(key), GetKeySize(key), frozen->seed), frozen->seed);
+			unsorted[i].bucket    = GetRange(unsorted[i].scattered, frozen->bucketscnt);
+			++firsts[unsorted[i].bucket + 1];
+		}
+		Count longest = 0;
+		for (Count b = 0; b < frozen->bucketscnt; ++b)
+			if (firsts[b + 1] > longest) longest = firsts[b + 1];
+		Fill(positions, 0, (longest + 2) * sizeof(U64));
+		for (Count b = 0; b < frozen->bucketscnt; ++b) ++positions[longest - firsts[b + 1] + 1];
+		for (Count l = 0; l <= longest; ++l) positions[l + 1] += positions[l];
+		for (Count b = 0; b < frozen->bucketscnt; ++b) buckets[positions[longest - firsts[b + 1]]++] = b;
+		for (Count b = 0; b < frozen->bucketscnt; ++b) firsts[b + 1] += firsts[b];
+		for (Count i = 0; i < n; ++i) keys[firsts[unsorted[i].bucket]++] = unsorted[i];
+		for (Count b = frozen->bucketscnt; b > 0; --b) firsts[b] = firsts[b - 1];
+		firsts[0] = 0;
+		if (CheckScattered(keys, firsts, frozen->bucketscnt)) continue;
+
+		Fill(frozen->pilots, 0, frozen->bucketscnt * sizeof(U32));
+		Fill(taken, 0, ((n + 63) >> 6) * sizeof(U64));
+		if (PlaceBuckets(frozen, keys, firsts, buckets, positions, taken)) break;
+	}
+
+	/* records go to the heap in position order, so neighbouring slots share
+	   lines; blobs are folded in. */
+	Assert(heapsz < 1ull << FROZEN_OFFSET_BITS);
+	for (Count i = 0; i < n; ++i) frozen->slots[positions[i]] = (U64)i;
+	Size offset = 0;
+	for (Count p = 0; p < n; ++p) {
+		FrozenKey *key = &keys[frozen->slots[p]];
+		FoldKey(key->key, (TableKey *)(frozen->heap + offset));
+		frozen->slots[p] = offset | GetFrozenPrint(key->scattered);
+		offset += GaugeKey(key->key);
+	}
+
+	ReleaseMemory((void *)scratch);
+	return 1;
+}
+
+/* the index of a frozen key, or 0 if it is absent; one key compare at most.
+   `strhash` is XXH3 under the seed of the frozen table, whatever the hash of
+   its source. */
+Index *FetchFrozenHashed(Byte *str, Count strsz, U64 strhash, FrozenTable *frozen)
+{
+	if (!frozen->quantity) return 0;
+	U64       scattered = Scatter(strhash, frozen->seed);
+	U32       pilot     = frozen->pilots[GetRange(scattered, frozen->bucketscnt)];
+	U64       slot      = frozen->slots[GetFrozenPosition(scattered, pilot, frozen)];
+	if ((slot ^ GetFrozenPrint(scattered)) >> FROZEN_OFFSET_BITS) return 0;
+	TableKey *key       = (TableKey *)(frozen->heap + (slot & ((1ull << FROZEN_OFFSET_BITS) - 1)));
+	if (key->size != strsz || Test(key->data, str, strsz)) return 0;
+	return GetKeyIndex(key);
+}
+
+Index *FetchFrozen(Byte *str, Count strsz, FrozenTable *frozen)
+{
+	return FetchFrozenHashed(str, strsz, HashXXH3(str, strsz, frozen->seed), frozen);
+}
+
+/*****************************************************************/
+
+/* perfect hash tables over key sets known at compile time: the table is a
+   constant, built by the compiler, and a lookup is a hash, a pilot load, a
+   slot load and one key compare. */
+typedef struct {
+	const Byte *data;
+	Count       size;
+} StaticKey;
+
+typedef struct {
+	const Byte *data;
+	Count       size;
+	Index       id;
+} StaticSlot;
+
+template <Count L>
+static constexpr StaticKey MakeStaticKey(const Byte (&str)[L])
+{
+	return {str, L - 1};
+}
+
+static constexpr Count GetStaticCapacity(Count n)
+{
+	Count capacity = 2;
+	while (capacity < n) capacity <<= 1;
+	return capacity;
+}
+
+/* loads of 4 or 8 bytes; assembled by shifts in constant evaluation and
+   copied at run time, which gives the same little-endian words. */
+template <Count S>
+static inline constexpr U64 LoadStatic(const Byte *str)
+{
+	U64 word = 0;
+	if (__builtin_is_constant_evaluated())
+		for (Count j = 0; j < S; ++j) word |= (U64)(unsigned char)str[j] << (j << 3);
+	else Copy(&word, str, S);
+	return word;
+}
+
+/* word at a time, with the tail read as an overlapping word so that no load
+   depends on the length; short keys are read as two overlapping halves. */
+static inline constexpr U64 HashStatic(const Byte *str, Count strsz)
+{
+	U64 hash = (U64)strsz * 0x9E3779B97F4A7C15ull;
+	U64 word = 0;
+	if (strsz >= 8) {
+		for (Count i = 0; i + 8 < strsz; i += 8) {
+			hash = (hash ^ LoadStatic<8>(str + i)) * 0xBF58476D1CE4E5B9ull;
+			hash ^= hash >> 31;
+		}
+		word = LoadStatic<8>(str + strsz - 8);
+	} else if (strsz >= 4) {
+		word = LoadStatic<4>(str) | LoadStatic<4>(str + strsz - 4) << 32;
+	} else if (strsz) {
+		word = (U64)(unsigned char)str[0] | (U64)(unsigned char)str[strsz >> 1] << 8 | (U64)(unsigned char)str[strsz - 1] << 16;
+	}
+	hash = (hash ^ word) * 0x94D049BB133111EBull;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+template <Count N>
+struct StaticTable {
+	static constexpr Count quantity   = GetStaticCapacity(N) << 1;
+	static constexpr Count bucketscnt = GetStaticCapacity(N >> 1);
+	static constexpr Count shift      = 64 - __builtin_ctzll(bucketscnt);
+	U64        pilots[bucketscnt];
+	StaticSlot slots[quantity];
+};
+
+template <Count N>
+static constexpr StaticTable<N> MakeStaticTable(const StaticKey (&keys)[N])
+{
+	typedef StaticTable<N> T;
+	T table = {};
+	U64   hashes[N]             = {};
+	Count lengths[T::bucketscnt] = {};
+	for (Count i = 0; i < T::quantity; ++i) table.slots[i].id = -1;
+	for (Count i = 0; i < N; ++i) {
+		hashes[i] = HashStatic(keys[i].data, keys[i].size);
+		++lengths[hashes[i] >> T::shift];
+	}
+
+	/* buckets are placed largest first. */
+	for (Count placed = 0; placed < T::bucketscnt; ++placed) {
+		Count bucket = 0;
+		for (Count b = 1; b < T::bucketscnt; ++b)
+			if (lengths[b] > lengths[bucket]) bucket = b;
+		if (lengths[bucket] <= 0) break;
+		lengths[bucket] = -1;
+
+		/* a trial marks its slots with -2 - key, then either fills or clears
+		   them; failing the assert stops the constant evaluation. */
+		for (U64 pilot = 0;; ++pilot) {
+			Assert(pilot < STATIC_ATTEMPTS);
+			Boolean collides = 0;
+			for (Count i = 0; i < N && !collides; ++i) {
+				if ((Count)(hashes[i] >> T::shift) != bucket) continue;
+				U64 slot = Scatter(hashes[i], pilot) & (T::quantity - 1);
+				if (table.slots[slot].id != -1) collides = 1;
+				else table.slots[slot].id = -2 - i;
+			}
+			for (Count i = 0; i < T::quantity; ++i) {
+				Index id = table.slots[i].id;
+				if (id > -2) continue;
+				if (collides) table.slots[i] = {0, 0, -1};
+				else table.slots[i] = {keys[-2 - id].data, keys[-2 - id].size, -2 - id};
+			}
+			if (!collides) {
+				table.pilots[bucket] = pilot;
+				break;
+			}
+		}
+	}
+	return table;
+}
+
+/* the position of the key in the list the table was made from, or -1. */
+template <Count N>
+static inline Index FetchStatic(const StaticTable<N> &table, const Byte *str, Count strsz)
+{
+	U64 hash = HashStatic(str, strsz);
+	U64 pilot = table.pilots[hash >> StaticTable<N>::shift];
+	const StaticSlot *slot = &table.slots[Scatter(hash, pilot) & (StaticTable<N>::quantity - 1)];
+	if (slot->size != strsz || Test(slot->data, str, strsz)) return -1;
+	return slot->id;
+}
+
+/*****************************************************************/
+
+#define SNAPSHOT_MAGIC (0x31454C4241545553ull) /* "SUTABLE1" */
+
+/* a snapshot is this header, then at `origin` the rows of the table at a
+   stride of `width`, each with its overflow pages folded in. a loaded table
+   runs on the mapped rows as they are. */
+typedef struct {
+	U64     magic;
+	Size    origin;
+	Count   quantity;
+	Size    width;
+	Size    granularity;
+	U64     seed;
+	Count   hash;
+	Count   tolerance;
+	Count   population;
+	Boolean interning;
+} TableSnapshot;
+
+static Boolean WriteWhole(HANDLE file, void *data, Size size)
+{
+	while (size) {
+		DWORD chunk = size < (1ull << 30) ? (DWORD)size : (DWORD)(1ull << 30);
+		DWORD written;
+		if (!WriteFile(file, data, chunk, &written, 0) || written != chunk) return 0;
+		data = (Byte *)data + chunk;
+		size -= chunk;
+	}
+	return 1;
+}
+
+/* the folded size of a row, without its terminator. */
+static Size GaugeRow(TableRow *row)
+{
+	Size extent = sizeof(TableRow);
+	for (; row; row = (TableRow *)row->overflow) {
+		extent += row->extent - sizeof(TableRow);
+		for (TableKey *key = row->keys; key->size > 0; key = GetNextKey(key))
+			if (key->size & BLOB_FLAG) extent += GaugeKey(key) - ((Address)GetNextKey(key) - (Address)key);
+	}
+	return extent;
+}
+
+/* the keys of a row and its overflow pages, with blobs folded in. */
+static Boolean WriteKeys(HANDLE file, TableRow *row)
+{
+	Boolean saved = 1;
+	for (; saved && row; row = (TableRow *)row->overflow) {
+		Address run = (Address)row->keys;
+		for (TableKey *key = row->keys; saved && key->size > 0; key = GetNextKey(key)) {
+			if (!(key->size & BLOB_FLAG)) continue;
+			Count strsz  = GetKeySize(key);
+			U64   zeros  = 0;
+			TableKey header = {strsz};
+			saved = WriteWhole(file, (void *)run, (Address)key - run)
+			     && WriteWhole(file, &header, sizeof(header))
+			     && WriteWhole(file, GetKeyData(key), strsz)
+			     && WriteWhole(file, &zeros, GaugeKey(key) - sizeof(TableKey) - sizeof(Index) - strsz)
+			     && WriteWhole(file, GetKeyIndex(key), sizeof(Index));
+			run = (Address)GetNextKey(key);
+		}
+		saved = saved && WriteWhole(file, (void *)run, (Address)row + row->extent - run);
+	}
+	return saved;
+}
+
+/* the header of a snapshot of `table`. the stride is the least power of two
+   that holds the longest folded row, so lookups in the loaded table stay a
+   shift; the rest of each stride is left a hole. */
+static TableSnapshot DescribeTable(Table *table)
+{
+	Size width = 1;
+	for (Count i = 0; i < table->quantity; ++i) {
+		Size extent = GaugeRow((TableRow *)(table->address + i * table->width)) + sizeof(TableKey);
+		while (width < extent) width <<= 1;
+	}
+
+	TableSnapshot snapshot = {};
+	snapshot.magic       = SNAPSHOT_MAGIC;
+	snapshot.origin      = AlignForwards(sizeof(TableSnapshot), GetPageSize());
+	snapshot.quantity    = table->quantity;
+	snapshot.width       = width;
+	snapshot.granularity = table->granularity;
+	snapshot.seed        = table->seed;
+	snapshot.hash        = table->hash;
+	snapshot.tolerance   = table->tolerance;
+	snapshot.population  = table->population;
+	snapshot.interning   = table->interning;
+	return snapshot;
+}
+
+/* creates the snapshot file at `path` as a sparse one. the holes between rows
+   then take no disk, though a loaded table still maps `width` per row, and a
+   copy of the file to a volume without sparse files writes them out whole. */
+static HANDLE CreateSnapshot(const char *path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE) return file;
+	DWORD returned;
+	DeviceIoControl(file, FSCTL_SET_SPARSE, 0, 0, 0, 0, &returned, 0);
+	return file;
+}
+
+/* writes the `i`th row of a snapshot from `row` and its overflow pages. */
+static Boolean WriteRow(HANDLE file, TableSnapshot *snapshot, Count i, TableRow *row)
+{
+	TableRow      header = {snapshot->width, GaugeRow(row), 0, 0, row->filter};
+	TableKey      terminator = {0};
+	LARGE_INTEGER offset;
+	offset.QuadPart = snapshot->origin + i * snapshot->width;
+	Boolean saved = SetFilePointerEx(file, offset, 0, FILE_BEGIN) && WriteWhole(file, &header, sizeof(header));
+	return saved && WriteKeys(file, row) && WriteWhole(file, &terminator, sizeof(terminator));
+}
+
+static Boolean EndSnapshot(HANDLE file, TableSnapshot *snapshot)
+{
+	LARGE_INTEGER end;
+	end.QuadPart = snapshot->origin + snapshot->quantity * snapshot->width;
+	return SetFilePointerEx(file, end, 0, FILE_BEGIN) && SetEndOfFile(file);
+}
+
+/* writes `table` to `path`. */
+Boolean Save(Table *table, const char *path)
+{
+	TableSnapshot snapshot = DescribeTable(table);
+	HANDLE file = CreateSnapshot(path);
+	if (file == INVALID_HANDLE_VALUE) return 0;
+	Boolean saved = WriteWhole(file, &snapshot, sizeof(snapshot));
+	for (Count i = 0; saved && i < table->quantity; ++i)
+		saved = WriteRow(file, &snapshot, i, (TableRow *)(table->address + i * table->width));
+	saved = saved && EndSnapshot(file, &snapshot);
+	CloseHandle(file);
+	return saved;
+}
+
+/* makes `table` an interning one again from the ids in its indices. */
+static Boolean Reenlist(Table *table)
+{
+	table->symbolssz = table->granularity;
+	while (table->symbolssz < table->population * sizeof(TableKey *)) table->symbolssz <<= 1;
+	table->symbols = (Address)CarvePool(table, table->symbolssz);
+	if (!table->symbols) return 0;
+	for (Count i = 0; i < table->quantity; ++i) {
+		TableRow *row = (TableRow *)(table->address + i * table->width);
+		for (TableKey *key = row->keys; key->size;) {
+			if (key->size < 0) {
+				row = (TableRow *)row->overflow;
+				key = row->keys;
+				continue;
+			}
+			((TableKey **)table->symbols)[*GetKeyIndex(key)] = key;
+			key = GetNextKey(key);
+		}
+	}
+	table->interning = 1;
+	return 1;
+}
+
+/* maps the snapshot at `path` into `table`, read-only or, if `writable`,
+   copy-on-write. Fetch on a read-only table returns 0 for absent keys; a
+   writable one spills new keys to the pool, leaving the file as it was. */
+Boolean Load(Table *table, const char *path, Boolean writable)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE) return 0;
+	LARGE_INTEGER filesz;
+	if (!GetFileSizeEx(file, &filesz) || filesz.QuadPart < (long long)sizeof(TableSnapshot)) {
+		CloseHandle(file);
+		return 0;
+	}
+	HANDLE mapping = CreateFileMappingA(file, 0, writable ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+	if (!mapping) return 0;
+	void *view = MapViewOfFile(mapping, writable ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view) return 0;
+
+	/* rows are addressed by shifts and masks, and must lie within the file. */
+	TableSnapshot *snapshot = (TableSnapshot *)view;
+	Size           size     = (Size)filesz.QuadPart;
+	if (snapshot->magic != SNAPSHOT_MAGIC || (U64)snapshot->hash >= TableHash_Count
+	 || snapshot->quantity <= 0 || !CheckAlignment(snapshot->quantity)
+	 || snapshot->width < sizeof(TableRow) + sizeof(TableKey) || !CheckAlignment(snapshot->width)
+	 || snapshot->origin > size || snapshot->quantity > (Count)((size - snapshot->origin) / snapshot->width)) {
+		UnmapViewOfFile(view);
+		return 0;
+	}
+	table->reservation = snapshot->quantity * snapshot->width;
+	table->granularity = snapshot->granularity;
+	table->quantity    = snapshot->quantity;
+	table->address     = (Address)view + snapshot->origin;
+	table->width       = snapshot->width;
+	table->spillage    = 0;
+	table->blobs       = 0;
+	table->seed        = snapshot->seed;
+	table->hash        = (TableHash)snapshot->hash;
+	table->tolerance   = snapshot->tolerance;
+	table->population  = snapshot->population;
+	table->interning   = 0;
+	table->symbols     = 0;
+	table->symbolssz   = 0;
+	table->view        = (Address)view;
+	table->sealed      = !writable;
+
+	/* the reverse array of an interning table holds addresses, so it is
+	   rebuilt from the mapped keys rather than saved. */
+	if (snapshot->interning && !Reenlist(table)) {
+		Destroy(table);
+		return 0;
+	}
+	return 1;
+}
+
+/* a snapshot written by a thread of its own while the table stays in use.
+   each row is either written by that thread or, if a writer reaches it
+   first, folded into `arena` by the writer beforehand; `states` holds 0 for
+   a row neither has claimed, 1 while one of them copies it, 2 once it is
+   written, and otherwise the address of the folded copy. */
+struct TableImage {
+	Table          *table;
+	Address         address;
+	Size            width;
+	TableSnapshot   snapshot;
+	HANDLE          file;
+	HANDLE          thread;
+	volatile LONG64 *states;
+	TableArena      arena;
+	Boolean         saved;
+};
+
+/* `row` and its overflow pages into `folded`, blobs folded in and a size 0
+   key after the last, which the writer of the snapshot stops at. */
+static void FoldRow(TableRow *row, TableRow *folded)
+{
+	Address at = (Address)folded->keys;
+	folded->filter = row->filter;
+	for (; row; row = (TableRow *)row->overflow) {
+		Address run = (Address)row->keys;
+		for (TableKey *key = row->keys; key->size > 0; key = GetNextKey(key)) {
+			if (!(key->size & BLOB_FLAG)) continue;
+			Copy((void *)at, (void *)run, (Address)key - run);
+			at += (Address)key - run;
+			FoldKey(key, (TableKey *)at);
+			at += GaugeKey(key);
+			run = (Address)GetNextKey(key);
+		}
+		Copy((void *)at, (void *)run, (Address)row + row->extent - run);
+		at += (Address)row + row->extent - run;
+	}
+	((TableKey *)at)->size = 0;
+	folded->commission = 0;
+	folded->extent     = at - (Address)folded;
+	folded->overflow   = 0;
+	folded->dirty      = 0;
+}
+
+/* keeps rows [beginning, beginning + count) as they were when the image
+   began, before the caller changes them. */
+static void Preserve(Table *table, Count beginning, Count count)
+{
+	TableImage *image = table->image;
+	for (Count i = beginning; i < beginning + count; ++i) {
+		volatile LONG64 *state = &image->states[i];
+		for (;;) {
+			LONG64 claim = *state;
+			if (claim > 1) break;
+			if (!claim && !InterlockedCompareExchange64(state, 1, 0)) {
+				TableRow *row    = (TableRow *)(image->address + i * image->width);
+				Size      extent = GaugeRow(row) + sizeof(TableKey);
+				Size      size   = sizeof(TableRow);
+				while (size < extent) size <<= 1;
+				TableRow *folded = (TableRow *)Carve(&image->arena, size);
+				Assert(folded);
+				FoldRow(row, folded);
+				InterlockedExchange64(state, (LONG64)folded);
+				break;
+			}
+			YieldProcessor();
+		}
+	}
+}
+
+static DWORD WINAPI WriteImage(LPVOID parameter)
+{
+	TableImage *image  = (TableImage *)parameter;
+	TableRow   *buffer = (TableRow *)AllocateMemory(image->snapshot.width);
+	Boolean     saved  = 1;
+	for (Count i = 0; i < image->snapshot.quantity; ++i) {
+		volatile LONG64 *state = &image->states[i];
+		TableRow *row;
+		for (;;) {
+			LONG64 claim = *state;
+			if (claim > 2) {
+				row = (TableRow *)claim;
+				break;
+			}
+			if (!claim && !InterlockedCompareExchange64(state, 1, 0)) {
+				FoldRow((TableRow *)(image->address + i * image->width), buffer);
+				InterlockedExchange64(state, 2);
+				row = buffer;
+				break;
+			}
+			YieldProcessor();
+		}
+		saved = saved && WriteRow(image->file, &image->snapshot, i, row);
+	}
+	image->saved = saved && EndSnapshot(image->file, &image->snapshot);
+	ReleaseMemory(buffer);
+	return 0;
+}
+
+/* starts writing `table` to `path` as it is now, in the background. the
+   table stays usable meanwhile, and a writer copies a row only the first
+   time it changes it; writes through the index Fetch returns are not seen,
+   so values changed during the save go through Store. */
+Boolean BeginSave(Table *table, TableImage *image, const char *path)
+{
+	image->table    = table;
+	image->address  = table->address;
+	image->width    = table->width;
+	image->snapshot = DescribeTable(table);
+	image->saved    = 0;
+	image->file     = CreateSnapshot(path);
+	if (image->file == INVALID_HANDLE_VALUE) return 0;
+	if (!WriteWhole(image->file, &image->snapshot, sizeof(image->snapshot))) {
+		CloseHandle(image->file);
+		return 0;
+	}
+	image->states = (volatile LONG64 *)AllocateMemory(AlignForwards(table->quantity * sizeof(LONG64), GetPageSize()));
+	image->arena  = {};
+	InitializeArena(&image->arena);
+	table->image  = image;
+	image->thread = CreateThread(0, 0, WriteImage, image, 0, 0);
+	Assert(image->thread);
+	return 1;
+}
+
+/* waits for the save to finish and tells whether it succeeded. */
+Boolean EndSave(TableImage *image)
+{
+	WaitForSingleObject(image->thread, INFINITE);
+	CloseHandle(image->thread);
+	CloseHandle(image->file);
+	if (image->table->image == image) image->table->image = 0;
+	DestroyArena(&image->arena);
+	ReleaseMemory((void *)image->states);
+	return image->saved;
+}
+
+/*****************************************************************/
+
+#define SHARE_MAGIC (0x31455241485355ull) /* "USHARE1" */
+
+/* a table in a named segment that several processes map at the same base, so
+   that its addresses hold in each of them. writers take a row by making its
+   version odd and release it by making it even again; readers take no lock
+   and retry a row whose version moved under them. rows grow in place up to
+   the table width and never spill, and the table is never rebuilt. */
+typedef struct {
+	U64     magic;
+	Address base;
+	Size    size;
+	Table   table;
+	volatile LONG64 versions[];
+} TableShare;
+
+typedef struct {
+	HANDLE      mapping;
+	TableShare *share;
+	Boolean     writable;
+} SharedTable;
+
+static inline Size GetShareHeaderSize(Count quantity)
+{
+	return AlignForwards(sizeof(TableShare) + quantity * sizeof(LONG64), GetPageSize());
+}
+
+/* creates the segment `name` for a table of `quantity` rows over
+   `reservation` bytes, 0 for the defaults, keyed by `hash`, and attaches to
+   it as a writer. the others attaching read the hash from the segment. */
+Boolean CreateShared(SharedTable *shared, const char *name, Count quantity, Size reservation, TableHash hash)
+{
+	if (!quantity)    quantity    = DEFAULT_QUANTITY;
+	if (!reservation) reservation = DEFAULT_RESERVATION;
+	reservation = AlignForwards(reservation, GetPageSize());
+	Size headersz = GetShareHeaderSize(quantity);
+	Size size     = headersz + reservation;
+
+	shared->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE | SEC_RESERVE, (DWORD)(size >> 32), (DWORD)size, name);
+	if (!shared->mapping) return 0;
+	TableShare *share = (TableShare *)MapViewOfFile(shared->mapping, FILE_MAP_WRITE, 0, 0, size);
+	if (!share) {
+		CloseHandle(shared->mapping);
+		return 0;
+	}
+	CommitMemory(share, headersz);
+	share->magic  = SHARE_MAGIC;
+	share->base   = (Address)share;
+	share->size   = size;
+
+	Table *table = &share->table;
+	table->reservation = reservation;
+	table->quantity    = quantity;
+	table->hash        = hash;
+	table->address     = (Address)share + headersz;
+	table->view        = (Address)share;
+	table->shared      = 1;
+	table->tolerance   = -1;
+	/* blobs carved in one process would not be mapped in the others. */
+	table->threshold   = -1;
+	Initialize(table);
+
+	shared->share    = share;
+	shared->writable = 1;
+	return 1;
+}
+
+/* maps the segment `name` at the base its creator did, read-only unless
+   `writable`; fails if that range is taken in this process. */
+Boolean AttachShared(SharedTable *shared, const char *name, Boolean writable)
+{
+	DWORD access = writable ? FILE_MAP_WRITE : FILE_MAP_READ;
+	shared->mapping = OpenFileMappingA(access, 0, name);
+	if (!shared->mapping) return 0;
+	TableShare *header = (TableShare *)MapViewOfFile(shared->mapping, FILE_MAP_READ, 0, 0, sizeof(TableShare));
+	TableShare *share  = 0;
+	if (header) {
+		if (header->magic == SHARE_MAGIC)
+			share = (TableShare *)MapViewOfFileEx(shared->mapping, access, 0, 0, header->size, (void *)header->base);
+		UnmapViewOfFile(header);
+	}
+	if (!share) {
+		CloseHandle(shared->mapping);
+		return 0;
+	}
+	shared->share    = share;
+	shared->writable = writable;
+	return 1;
+}
+
+/* unmaps the segment; it goes away with the last process attached. */
+void DetachShared(SharedTable *shared)
+{
+	UnmapViewOfFile(shared->share);
+	CloseHandle(shared->mapping);
+	shared->share = 0;
+}
+
+/* enters `str` with `value` under the lock of its row; fails if the row is
+   full or the attachment is read-only. */
+Boolean StoreShared(Byte *str, Count strsz, Index value, SharedTable *shared)
+{
+	if (!shared->writable) return 0;
+	Table           *table   = &shared->share->table;
+	U64              strhash = GetKeyHash(table, str, strsz);
+	volatile LONG64 *version = &shared->share->versions[GetRowIndex(strhash, table)];
+	LONG64           taken;
+	for (;;) {
+		taken = *version;
+		if (!(taken & 1) && InterlockedCompareExchange64(version, taken + 1, taken) == taken) break;
+		YieldProcessor();
+	}
+	Index *index = FetchHashed(str, strsz, strhash, table);
+	if (index) *index = value;
+	InterlockedExchange64(version, taken + 2);
+	return index != 0;
+}
+
+/* looks `str` up without a lock, and copies its value out if it is there. */
+Boolean FindShared(Byte *str, Count strsz, Index *value, SharedTable *shared)
+{
+	Table           *table   = &shared->share->table;
+	U64              strhash = GetKeyHash(table, str, strsz);
+	volatile LONG64 *version = &shared->share->versions[GetRowIndex(strhash, table)];
+	TableRow        *row     = GetRow(strhash, table);
+	for (;;) {
+		LONG64 seen = *version;
+		if (seen & 1) {
+			YieldProcessor();
+			continue;
+		}
+		Boolean found = 0;
+		if (TestFilter(row, GetFilterBits(strhash))) {
+			TableKey *key = row->keys;
+			for (; key->size > 0; key = GetNextKey(key))
+				if (key->size == strsz && !Test(key->data, str, strsz)) break;
+			found = key->size > 0;
+			if (found) *value = *GetKeyIndex(key);
+		}
+		MemoryBarrier();
+		if (*version == seen) return found;
+	}
+}
+
+/*****************************************************************/
+
+#define CHECKPOINT_MAGIC (0x31544E494F504B43ull) /* "CKPOINT1" */
+
+/* a checkpoint file is a run of batches, each this header and, for every row
+   dirty since the previous batch, a CheckpointRow and the row's keys with its
+   overflow pages folded in. a batch of another quantity, seed or hash than
+   the one before it follows a rebuild and supersedes all earlier batches. */
+typedef struct {
+	U64     magic;
+	Size    size;
+	Count   quantity;
+	U64     seed;
+	Count   hash;
+	Count   tolerance;
+	Count   population;
+	Boolean interning;
+	Count   rowscnt;
+} TableCheckpoint;
+
+typedef struct {
+	Count row;
+	Size  extent;
+	U32   filter;
+} CheckpointRow;
+
+/* appends the rows changed since the last checkpoint to the file at `path`
+   and clears their dirty bits once the batch is on disk. a failed batch is cut
+   off the file, and its rows stay dirty for the next checkpoint. */
+Boolean Checkpoint(Table *table, const char *path)
+{
+	TableCheckpoint checkpoint = {};
+	checkpoint.magic      = CHECKPOINT_MAGIC;
+	checkpoint.size       = sizeof(TableCheckpoint);
+	checkpoint.quantity   = table->quantity;
+	checkpoint.seed       = table->seed;
+	checkpoint.hash       = table->hash;
+	checkpoint.tolerance  = table->tolerance;
+	checkpoint.population = table->population;
+	checkpoint.interning  = table->interning;
+	for (Count i = 0; i < table->quantity; ++i) {
+		TableRow *row = (TableRow *)(table->address + i * table->width);
+		if (!row->dirty) continue;
+		checkpoint.size += sizeof(CheckpointRow) + GaugeRow(row) - sizeof(TableRow);
+		++checkpoint.rowscnt;
+	}
+
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE) return 0;
+	LARGE_INTEGER origin = {}, end = {};
+	if (!SetFilePointerEx(file, origin, &end, FILE_END)) {
+		CloseHandle(file);
+		return 0;
+	}
+	Boolean saved = WriteWhole(file, &checkpoint, sizeof(checkpoint));
+	for (Count i = 0; saved && i < table->quantity; ++i) {
+		TableRow *row = (TableRow *)(table->address + i * table->width);
+		if (!row->dirty) continue;
+		CheckpointRow header = {i, GaugeRow(row), row->filter};
+		saved = WriteWhole(file, &header, sizeof(header)) && WriteKeys(file, row);
+	}
+	saved = saved && FlushFileBuffers(file);
+	if (saved) {
+		for (Count i = 0; i < table->quantity; ++i)
+			((TableRow *)(table->address + i * table->width))->dirty = 0;
+	} else if (SetFilePointerEx(file, end, 0, FILE_BEGIN)) {
+		SetEndOfFile(file);
+	}
+	CloseHandle(file);
+	return saved;
+}
+
+/* whether `keyssz` bytes at `keys` are whole inline keys and nothing else. */
+static Boolean CheckKeys(TableKey *keys, Size keyssz)
+{
+	Address end = (Address)keys + keyssz;
+	for (TableKey *key = keys; (Address)key < end; key = GetNextKey(key))
+		if ((Address)key + sizeof(TableKey) > end || key->size <= 0 || key->size & BLOB_FLAG
+		 || (Size)key->size > end - (Address)key || (Address)GetNextKey(key) > end)
+			return 0;
+	return 1;
+}
+
+/* initializes `table` to the state of the last whole batch in the checkpoint
+   file at `path`; a batch cut short by a crash is ignored. fails, leaving
+   `table` as it was, on a batch that does not hold together: a quantity that
+   is not a power of two or too many rows for the reservation, or rows out of
+   range or past the end of their batch. */
+Boolean Restore(Table *table, const char *path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE) return 0;
+	LARGE_INTEGER filesz;
+	if (!GetFileSizeEx(file, &filesz) || filesz.QuadPart < (long long)sizeof(TableCheckpoint)) {
+		CloseHandle(file);
+		return 0;
+	}
+	HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+	if (!mapping) return 0;
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view) return 0;
+
+	/* the newest record of every row, found walking the batches in order. */
+	Address          end         = (Address)view + filesz.QuadPart;
+	TableCheckpoint *last        = 0;
+	CheckpointRow  **latest      = 0;
+	Boolean          whole       = 1;
+	/* rows of at least a page each must fit the reservation Initialize makes. */
+	Size             reservation = table->reservation ? table->reservation : DEFAULT_RESERVATION;
+	for (Address at = (Address)view; whole && at + sizeof(TableCheckpoint) <= end;) {
+		TableCheckpoint *checkpoint = (TableCheckpoint *)at;
+		if (checkpoint->magic != CHECKPOINT_MAGIC || checkpoint->size > end - at) break;
+		Address ending = at + checkpoint->size;
+		whole = (U64)checkpoint->hash < TableHash_Count && checkpoint->size >= sizeof(TableCheckpoint)
+		     && checkpoint->quantity > 0 && CheckAlignment(checkpoint->quantity)
+		     && (table->arena || checkpoint->quantity <= (Count)(reservation / GetPageSize()));
+		if (!whole) break;
+		if (!last || last->quantity != checkpoint->quantity || last->seed != checkpoint->seed || last->hash != checkpoint->hash) {
+			if (latest) ReleaseMemory(latest);
+			latest = (CheckpointRow **)AllocateMemory(AlignForwards(checkpoint->quantity * sizeof(CheckpointRow *), GetPageSize()));
+		}
+		Address record = at + sizeof(TableCheckpoint);
+		for (Count i = 0; whole && i < checkpoint->rowscnt; ++i) {
+			CheckpointRow *row = (CheckpointRow *)record;
+			whole = record + sizeof(CheckpointRow) <= ending && row->row >= 0 && row->row < checkpoint->quantity
+			     && row->extent >= sizeof(TableRow) && row->extent - sizeof(TableRow) <= ending - record - sizeof(CheckpointRow)
+			     && CheckKeys((TableKey *)(row + 1), row->extent - sizeof(TableRow));
+			if (!whole) break;
+			latest[row->row] = row;
+			record += sizeof(CheckpointRow) + row->extent - sizeof(TableRow);
+		}
+		whole = whole && record == ending;
+		last = checkpoint;
+		at   = ending;
+	}
+	if (!last || !whole) {
+		if (latest) ReleaseMemory(latest);
+		UnmapViewOfFile(view);
+		return 0;
+	}
+
+	/* rows are copied in whole where they fit, and entered key by key where
+	   they do not; the geometry must hold meanwhile, so the guard is off. */
+	table->quantity  = last->quantity;
+	table->seed      = last->seed;
+	table->hash      = (TableHash)last->hash;
+	table->tolerance = -1;
+	table->interning = 0;
+	Initialize(table);
+	Boolean restored = 1;
+	for (Count i = 0; restored && i < table->quantity; ++i) {
+		CheckpointRow *record = latest[i];
+		if (!record || record->extent == sizeof(TableRow)) continue;
+		TableRow *row    = (TableRow *)(table->address + i * table->width);
+		TableKey *keys   = (TableKey *)(record + 1);
+		Size      keyssz = record->extent - sizeof(TableRow);
+		Size      extent = AlignForwards(record->extent + sizeof(TableKey), table->granularity);
+		if (extent <= table->width) {
+			if (extent > row->commission) {
+				CommitRow(table, (void *)((Address)row + row->commission), extent - row->commission);
+				row->commission = extent;
+			}
+			Copy(row->keys, keys, keyssz);
+			row->extent = record->extent;
+			row->filter = record->filter;
+			continue;
+		}
+		for (TableKey *key = keys; restored && (Address)key < (Address)keys + keyssz; key = GetNextKey(key)) {
+			Index *index = Fetch(key->data, key->size, table);
+			if (index) *index = *GetKeyIndex(key);
+			else       restored = 0;
+		}
+	}
+	table->tolerance  = last->tolerance;
+	table->population = last->population;
+	if (restored && last->interning) restored = Reenlist(table);
+
+	ReleaseMemory(latest);
+	UnmapViewOfFile(view);
+	if (!restored) Destroy(table);
+	return restored;
+}
+
+/*****************************************************************/
+
+/* a set that keeps no key bytes, only a fingerprint of each key: its 64-bit
+   hash, or its 128-bit one if `wide`. rows are cache lines of 8 narrow or 4
+   wide fingerprints, probed linearly from the row the fingerprint scatters
+   to, and an empty slot ends the probe. the set doubles before it is 7/8
+   full, so a key takes 8 to 18 bytes, or 16 to 37 if wide.
+
+   two keys are confused only if their fingerprints are equal, so a key that
+   was never marked is taken for marked with a chance of n / 2^64 in a set of
+   n keys, or n / 2^128 if wide; the zero fingerprint marks an empty slot
+   and is stored as 1. */
+typedef struct {
+	Count   quantity;
+	Count   population;
+	U64     seed;
+	Boolean wide;
+	Address address;
+} KeySet;
+
+typedef struct {
+	U64 low;
+	U64 high;
+} SetPrint;
+
+static inline SetPrint GetSetPrint(Byte *str, Count strsz, KeySet *set)
+{
+	SetPrint print = {};
+	if (set->wide) {
+		XXH128_hash_t strhash = XXH3_128bits_withSeed(str, strsz, set->seed);
+		print.low  = strhash.low64;
+		print.high = strhash.high64;
+	} else
+		print.low = HashXXH3(str, strsz, set->seed);
+	if (!print.low) print.low = 1;
+	return print;
+}
+
+void InitializeSet(KeySet *set)
+{
+	if (!set->quantity) set->quantity = DEFAULT_SET_QUANTITY;
+	if (!set->seed) set->seed = Random();
+	set->population = 0;
+	set->address    = (Address)AllocateMemory(AlignForwards(set->quantity * SET_ROW_SIZE, GetPageSize()));
+	Assert(CheckAlignment(set->quantity));
+}
+
+void DestroySet(KeySet *set)
+{
+	ReleaseMemory((void *)set->address);
+	set->address = 0;
+}
+
+/* the slot of `print`, or the empty slot that ends its probe; the row is
+   compared as two vectors, a bit of `matches` and `empties` per word. */
+static U64 *ProbeSet(SetPrint print, Boolean *found, KeySet *set)
+{
+	__m256i pattern = set->wide ? _mm256_setr_epi64x(print.low, print.high, print.low, print.high) : _mm256_set1_epi64x(print.low);
+	__m256i zero    = _mm256_setzero_si256();
+	U32     slots   = set->wide ? 0x55 : 0xFF;
+	Count   r       = Scatter(print.low, set->seed) & (set->quantity - 1);
+	for (;; r = (r + 1) & (set->quantity - 1)) {
+		U64    *row     = (U64 *)(set->address + r * SET_ROW_SIZE);
+		__m256i left    = _mm256_load_si256((__m256i *)row);
+		__m256i right   = _mm256_load_si256((__m256i *)row + 1);
+		U32     matches = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(left, pattern)))
+		                | _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(right, pattern))) << 4;
+		U32     empties = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(left, zero)))
+		                | _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(right, zero))) << 4;
+		/* a wide fingerprint matches in both words of its slot. */
+		if (set->wide) matches &= matches >> 1;
+		matches &= slots;
+		empties &= slots;
+		if (matches) {
+			*found = 1;
+			return row + _tzcnt_u32(matches);
+		}
+		if (empties) {
+			*found = 0;
+			return row + _tzcnt_u32(empties);
+		}
+	}
+}
+
+static void PlaceSetPrint(U64 *slot, SetPrint print, KeySet *set)
+{
+	slot[0] = print.low;
+	if (set->wide) slot[1] = print.high;
+}
+
+static void GrowSet(KeySet *set)
+{
+	KeySet grown = *set;
+	grown.quantity <<= 1;
+	InitializeSet(&grown);
+	Count words = set->quantity * SET_ROW_SIZE / sizeof(U64);
+	Count step  = set->wide ? 2 : 1;
+	for (Count i = 0; i < words; i += step) {
+		U64 *slot = (U64 *)set->address + i;
+		if (!slot[0]) continue;
+		SetPrint print = {slot[0], set->wide ? slot[1] : 0};
+		Boolean  found;
+		PlaceSetPrint(ProbeSet(print, &found, &grown), print, &grown);
+	}
+	grown.population = set->population;
+	DestroySet(set);
+	*set = grown;
+}
+
+/* marks `str` as seen; whether it was seen before. */
+Boolean Mark(Byte *str, Count strsz, KeySet *set)
+{
+	Count slots = set->quantity * SET_ROW_SIZE / (set->wide ? 16 : 8);
+	if ((set->population + 1) * 8 > slots * 7) GrowSet(set);
+	SetPrint print = GetSetPrint(str, strsz, set);
+	Boolean  found;
+	U64     *slot  = ProbeSet(print, &found, set);
+	if (found) return 1;
+	PlaceSetPrint(slot, print, set);
+	++set->population;
+	return 0;
+}
+
+/* whether `str` was marked, up to the false positives above. */
+Boolean Marked(Byte *str, Count strsz, KeySet *set)
+{
+	Boolean found;
+	ProbeSet(GetSetPrint(str, strsz, set), &found, set);
+	return found;
+}
+
+/*****************************************************************/
+
+/* a table of packed records on the rows of a Table: the key size in one byte,
+   or in two with the top bit of the first set, the key, and a 4-byte value,
+   with no padding, read with unaligned loads. a first byte of 0 ends the row
+   and of 0xFF continues it at `overflow`, so an empty key takes the two-byte
+   form and keys are at most MAX_COMPACT_KEY_SIZE bytes. rows, overflow pages,
+   filters and the flooding guard are those of the Table; snapshots,
+   checkpoints and cursors are not. */
+#define MAX_COMPACT_KEY_SIZE (0x7EFFll)
+
+typedef struct {
+	Table table;
+} CompactTable;
+
+static inline Byte *DecodeCompactSize(Byte *record, Count *strsz)
+{
+	U32 first = (unsigned char)record[0];
+	if (first < 0x80) {
+		*strsz = first;
+		return record + 1;
+	}
+	*strsz = (first & 0x7F) << 8 | (unsigned char)record[1];
+	return record + 2;
+}
+
+static inline Size GetCompactRecordSize(Count strsz)
+{
+	return (strsz && strsz < 0x80 ? 1 : 2) + strsz + sizeof(U32);
+}
+
+void InitializeCompact(CompactTable *compact)
+{
+	Initialize(&compact->table);
+}
+
+void DestroyCompact(CompactTable *compact)
+{
+	Destroy(&compact->table);
+}
+
+/* the record of `str` in its row, or the end of the row if it is absent;
+   `row` is left on the page of the result. */
+static Byte *SeekCompact(TableRow **row, Byte *str, Count strsz, Count *depth)
+{
+	Byte *record = (Byte *)(*row)->keys;
+	for (;;) {
+		unsigned char first = *record;
+		if (!first) return record;
+		if (first == 0xFF) {
+			*row   = (TableRow *)(*row)->overflow;
+			record = (Byte *)(*row)->keys;
+			continue;
+		}
+		Count size;
+		Byte *data = DecodeCompactSize(record, &size);
+		if (size == strsz && !Test(data, str, strsz)) return record;
+		record = data + size + sizeof(U32);
+		++*depth;
+	}
+}
+
+static Boolean StoreCompactHashed(Byte *str, Count strsz, U64 strhash, U32 value, CompactTable *compact);
+
+static Boolean RebuildCompact(CompactTable *compact, Count quantity, U64 seed)
+{
+	Table        *table   = &compact->table;
+	CompactTable  rebuilt = {};
+	rebuilt.table.reservation = table->reservation;
+	rebuilt.table.granularity = table->granularity;
+	rebuilt.table.quantity    = quantity;
+	rebuilt.table.seed        = seed;
+	rebuilt.table.hash        = table->hash;
+	rebuilt.table.tolerance   = -1;
+	rebuilt.table.arena       = table->arena;
+	rebuilt.table.backing     = table->backing;
+	if (rebuilt.table.arena) {
+		rebuilt.table.address = (Address)Carve(rebuilt.table.arena, rebuilt.table.reservation);
+		if (!rebuilt.table.address) return 0;
+	}
+	InitializeCompact(&rebuilt);
+
+	for (Count i = 0; i < table->quantity; ++i) {
+		TableRow *row    = (TableRow *)(table->address + i * table->width);
+		Byte     *record = (Byte *)row->keys;
+		while (*record) {
+			if ((unsigned char)*record == 0xFF) {
+				row    = (TableRow *)row->overflow;
+				record = (Byte *)row->keys;
+				continue;
+			}
+			Count size;
+			Byte *data = DecodeCompactSize(record, &size);
+			U32   value;
+			Copy(&value, data + size, sizeof(U32));
+			if (!StoreCompactHashed(data, size, GetKeyHash(&rebuilt.table, data, size), value, &rebuilt)) {
+				DestroyCompact(&rebuilt);
+				return 0;
+			}
+			record = data + size + sizeof(U32);
+		}
+	}
+	rebuilt.table.tolerance = table->tolerance;
+
+	DestroyCompact(compact);
+	*compact = rebuilt;
+	return 1;
+}
+
+static Boolean StoreCompactHashed(Byte *str, Count strsz, U64 strhash, U32 value, CompactTable *compact)
+{
+	Table    *table  = &compact->table;
+	TableRow *row    = GetRow(strhash, table);
+	U32       bits   = GetFilterBits(strhash);
+	Count     depth  = 0;
+	Byte     *record;
+
+	if (TestFilter(row, bits)) {
+		record = SeekCompact(&row, str, strsz, &depth);
+		if (*record) {
+			Count size;
+			Copy(DecodeCompactSize(record, &size) + size, &value, sizeof(U32));
+			return 1;
+		}
+	} else
+		record = (Byte *)GetRowEnd(&row);
+
+	if (strsz > MAX_COMPACT_KEY_SIZE) return 0;
+	if (table->tolerance > 0 && depth > FLOOD_DEPTH
+	 && depth > (table->population >> _tzcnt_u64(table->quantity)) * table->tolerance
+	 && RebuildCompact(compact, table->quantity, Random())) {
+		/* as in Reseed, a reseed that leaves the row as long stands the guard down. */
+		Count reseeded = 0;
+		strhash = GetKeyHash(table, str, strsz);
+		bits    = GetFilterBits(strhash);
+		row     = GetRow(strhash, table);
+		record = SeekCompact(&row, str, strsz, &reseeded);
+		if (reseeded >= depth) table->tolerance = -table->tolerance;
+	}
+	Size addition = GetCompactRecordSize(strsz);
+	if (row->extent + addition + sizeof(TableKey) > row->commission) {
+		Size commission = AlignForwards(addition, table->granularity);
+		if ((Address)row - table->address < table->reservation && row->commission + commission <= table->width) {
+			CommitRow(table, (void *)((Address)row + row->commission), commission);
+			row->commission += commission;
+		} else {
+			row = Spill(row, addition, table);
+			if (!row) return 0;
+			record = (Byte *)row->keys;
+		}
+	}
+	if (strsz && strsz < 0x80)
+		*record++ = (Byte)strsz;
+	else {
+		*record++ = (Byte)(0x80 | strsz >> 8);
+		*record++ = (Byte)strsz;
+	}
+	Copy(record, str, strsz);
+	Copy(record + strsz, &value, sizeof(U32));
+	row->extent += addition;
+	++table->population;
+	GetRow(strhash, table)->filter |= bits;
+	return 1;
+}
+
+/* enters or overwrites `str` with `value`; fails if the key is too long or
+   no memory is left. */
+Boolean StoreCompact(Byte *str, Count strsz, U32 value, CompactTable *compact)
+{
+	return StoreCompactHashed(str, strsz, GetKeyHash(&compact->table, str, strsz), value, compact);
+}
+
+/* copies the value of `str` out if it is there. */
+Boolean FindCompact(Byte *str, Count strsz, U32 *value, CompactTable *compact)
+{
+	Table    *table   = &compact->table;
+	U64       strhash = GetKeyHash(table, str, strsz);
+	TableRow *row     = GetRow(strhash, table);
+	Count     depth   = 0;
+	if (!TestFilter(row, GetFilterBits(strhash))) return 0;
+	Byte *record = SeekCompact(&row, str, strsz, &depth);
+	if (!*record) return 0;
+	Count size;
+	Copy(value, DecodeCompactSize(record, &size) + size, sizeof(U32));
+	return 1;
+}
+
+/******************************************/
+
+static inline Size GaugeString(Byte *str)
+{
+	return __builtin_strlen(str);
+}
+
+Byte *GetKeys(void)
+{
+	static Boolean initialized = 0;
+	static Byte keys[KEYS_COUNT][KEY_SIZE];
+	if (!initialized) {
+		Byte chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_0123456789";
+		Size charscnt = COUNTOF(chars) - 1;
+		for (Count i = 0; i < KEYS_COUNT; ++i) {
+			Byte *key = keys[i];
+			Count keysz = KEY_SIZE;
+			for (Count j = 0; j < keysz; ++j)
+				key[j] = chars[Random() % charscnt];
+			if (keysz == KEY_SIZE) --keysz;
+			key[keysz] = 0;
+		}
+		initialized = 1;
+	}
+	return &keys[0][0];
+}
+
+Size *GetKeySizes(void)
+{
+	static Boolean initialized = 0;
+	static Size sizes[KEYS_COUNT];
+	if (!initialized) {
+		Byte *keys = GetKeys();
+		for (Count i = 0; i < KEYS_COUNT; ++i)
+			sizes[i] = strlen(keys + i * KEY_SIZE);
+	}
+	return sizes;
+}
+
+/* the hashes of the keys for tables of KEYS_SEED, which the `Hashed`
+   benchmarks give their tables. */
+#define KEYS_SEED (0x6B657973ull)
+
+U64 *GetKeyHashes(void)
+{
+	static Boolean initialized = 0;
+	static U64 hashes[KEYS_COUNT];
+	if (!initialized) {
+		Byte *keys  = GetKeys();
+		Size *sizes = GetKeySizes();
+		for (Count i = 0; i < KEYS_COUNT; ++i)
+			hashes[i] = HashXXH3(keys + i * KEY_SIZE, sizes[i], KEYS_SEED);
+		initialized = 1;
+	}
+	return hashes;
+}
+
+#define Clock() ({ LARGE_INTEGER x; QueryPerformanceCounter(&x); x.QuadPart; })
+
+Table0 table0;
+Table  table;
+std::unordered_map<std::string_view, Index> umap;
+
+static void BM_Table0(benchmark::State &state)
+{
+	Initialize0(&table0);
+
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	Index i = 0;
+	for (auto _ : state) {
+		i %= KEYS_COUNT;
+		Byte *key  = keys + i * KEY_SIZE;
+		Size  size = sizes[i];
+		benchmark::DoNotOptimize(Fetch0(key, size, &table0));
+		++i;
+	}
+
+	Destroy0(&table0);
+}
+
+BENCHMARK(BM_Table0);
+
+static void BM_Table(benchmark::State &state)
+{
+	Initialize(&table);
+
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	Index i = 0;
+	for (auto _ : state) {
+		i %= KEYS_COUNT;
+		Byte *key  = keys + i * KEY_SIZE;
+		Size  size = sizes[i];
+		benchmark::DoNotOptimize(Fetch(key, size, &table));
+		++i;
+	}
+
+	Destroy(&table);
+}
+
+BENCHMARK(BM_Table);
+
+static void BM_Table0_Hashed(benchmark::State &state)
+{
+	table0.seed = KEYS_SEED;
+	Initialize0(&table0);
+
+	Byte *keys   = GetKeys();
+	Size *sizes  = GetKeySizes();
+	U64  *hashes = GetKeyHashes();
+	Index i = 0;
+	for (auto _ : state) {
+		i %= KEYS_COUNT;
+		benchmark::DoNotOptimize(Fetch0Hashed(keys + i * KEY_SIZE, sizes[i], hashes[i], &table0));
+		++i;
+	}
+
+	Destroy0(&table0);
+}
+
+BENCHMARK(BM_Table0_Hashed);
+
+static void BM_Table_Hashed(benchmark::State &state)
+{
+	table.seed = KEYS_SEED;
+	Initialize(&table);
+
+	Byte *keys   = GetKeys();
+	Size *sizes  = GetKeySizes();
+	U64  *hashes = GetKeyHashes();
+	Index i = 0;
+	for (auto _ : state) {
+		i %= KEYS_COUNT;
+		benchmark::DoNotOptimize(FetchHashed(keys + i * KEY_SIZE, sizes[i], hashes[i], &table));
+		++i;
+	}
+
+	Destroy(&table);
+}
+
+BENCHMARK(BM_Table_Hashed);
+
+/* each key taken as a tuple of three pieces. */
+static void BM_Table_Pieces(benchmark::State &state)
+{
+	Initialize(&table);
+
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	Index i = 0;
+	for (auto _ : state) {
+		i %= KEYS_COUNT;
+		Byte    *key       = keys + i * KEY_SIZE;
+		Size     size      = sizes[i];
+		KeyPiece pieces[3] = {{key, 8}, {key + 8, 12}, {key + 20, (Count)size - 20}};
+		benchmark::DoNotOptimize(FetchPieces(pieces, COUNTOF(pieces), &table));
+		++i;
+	}
+
+	Destroy(&table);
+}
+
+BENCHMARK(BM_Table_Pieces);
+
+/* the same tuples gathered into a scratch buffer first. */
+static void BM_Table_Concatenated(benchmark::State &state)
+{
+	Initialize(&table);
+
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	Byte  scratch[KEY_SIZE];
+	Index i = 0;
+	for (auto _ : state) {
+		i %= KEYS_COUNT;
+		Byte    *key       = keys + i * KEY_SIZE;
+		Size     size      = sizes[i];
+		KeyPiece pieces[3] = {{key, 8}, {key + 8, 12}, {key + 20, (Count)size - 20}};
+		Count    scratchsz = 0;
+		for (Count j = 0; j < COUNTOF(pieces); ++j) {
+			Copy(scratch + scratchsz, pieces[j].data, pieces[j].size);
+			scratchsz += pieces[j].size;
+		}
+		benchmark::DoNotOptimize(Fetch(scratch, scratchsz, &table));
+		++i;
+	}
+
+	Destroy(&table);
+}
+
+BENCHMARK(BM_Table_Concatenated);
+
+/* a key to its id and the id back to the key. */
+static void BM_Table_Intern(benchmark::State &state)
+{
+	Table symbols = {};
+	symbols.interning = 1;
+	Initialize(&symbols);
+
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	Index i = 0;
+	for (auto _ : state) {
+		i %= KEYS_COUNT;
+		Index id = Intern(keys + i * KEY_SIZE, sizes[i], &symbols);
+		benchmark::DoNotOptimize(GetSymbol(id, &symbols));
+		++i;
+	}
+
+	Destroy(&symbols);
+}
+
+BENCHMARK(BM_Table_Intern);
+
+/* full scans, reported as key and value bytes walked per second. */
+static void BM_Table0_Scan(benchmark::State &state)
+{
+	Count keyscnt = state.range(0);
+	Table0 scanned = {};
+	scanned.quantity = keyscnt >> 5;
+	Initialize0(&scanned);
+
+	Byte key[KEY_SIZE];
+	Copy(key, GetKeys(), KEY_SIZE);
+	for (Index i = 0; i < keyscnt; ++i) {
+		*(Index *)key = i;
+		*Fetch0(key, KEY_SIZE - 1, &scanned) = i;
+	}
+
+	for (auto _ : state) {
+		Table0Cursor cursor = {};
+		Begin0(&cursor, &scanned);
+		Index sum = 0;
+		for (Index *index; (index = Advance0(&cursor));)
+			sum += *index + cursor.key[cursor.keysz - 1];
+		benchmark::DoNotOptimize(sum);
+		End0(&cursor);
+	}
+	state.SetBytesProcessed(state.iterations() * keyscnt * (KEY_SIZE - 1 + sizeof(Index)));
+
+	Destroy0(&scanned);
+}
+
+BENCHMARK(BM_Table0_Scan)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_Table_Scan(benchmark::State &state)
+{
+	Count keyscnt = state.range(0);
+	Table scanned = {};
+	scanned.quantity = keyscnt >> 5;
+	Initialize(&scanned);
+
+	Byte key[KEY_SIZE];
+	Copy(key, GetKeys(), KEY_SIZE);
+	for (Index i = 0; i < keyscnt; ++i) {
+		*(Index *)key = i;
+		*Fetch(key, KEY_SIZE - 1, &scanned) = i;
+	}
+
+	for (auto _ : state) {
+		TableCursor cursor;
+		Begin(&cursor, &scanned);
+		Index sum = 0;
+		for (Index *index; (index = Advance(&cursor));)
+			sum += *index + cursor.key[cursor.keysz - 1];
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetBytesProcessed(state.iterations() * keyscnt * (KEY_SIZE - 1 + sizeof(Index)));
+
+	Destroy(&scanned);
+}
+
+BENCHMARK(BM_Table_Scan)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static U64 SumIndex(Byte *key, Count keysz, Index *index, void *context)
+{
+	return *index + key[keysz - 1];
+}
+
+static U64 Add(U64 left, U64 right)
+{
+	return left + right;
+}
+
+static void Increment(Byte *key, Count keysz, Index *index, void *context)
+{
+	++*index;
+}
+
+/* parallel scans of 1 << 20 keys by the number of threads. */
+static void BM_Table_Reduce(benchmark::State &state)
+{
+	Count keyscnt = 1 << 20;
+	Table scanned = {};
+	scanned.quantity = keyscnt >> 5;
+	Initialize(&scanned);
+
+	Byte key[KEY_SIZE];
+	Copy(key, GetKeys(), KEY_SIZE);
+	for (Index i = 0; i < keyscnt; ++i) {
+		*(Index *)key = i;
+		*Fetch(key, KEY_SIZE - 1, &scanned) = i;
+	}
+
+	ThreadPool pool = {};
+	pool.threadscnt = state.range(0);
+	InitializePool(&pool);
+	for (auto _ : state)
+		benchmark::DoNotOptimize(Reduce(&scanned, &pool, SumIndex, Add, 0, 0));
+	state.SetBytesProcessed(state.iterations() * keyscnt * (KEY_SIZE - 1 + sizeof(Index)));
+	DestroyPool(&pool);
+
+	Destroy(&scanned);
+}
+
+BENCHMARK(BM_Table_Reduce)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->UseRealTime();
+
+static void BM_Table_ForEach(benchmark::State &state)
+{
+	Count keyscnt = 1 << 20;
+	Table scanned = {};
+	scanned.quantity = keyscnt >> 5;
+	Initialize(&scanned);
+
+	Byte key[KEY_SIZE];
+	Copy(key, GetKeys(), KEY_SIZE);
+	for (Index i = 0; i < keyscnt; ++i) {
+		*(Index *)key = i;
+		*Fetch(key, KEY_SIZE - 1, &scanned) = i;
+	}
+
+	ThreadPool pool = {};
+	pool.threadscnt = state.range(0);
+	InitializePool(&pool);
+	for (auto _ : state)
+		ForEach(&scanned, &pool, Increment, 0);
+	state.SetBytesProcessed(state.iterations() * keyscnt * (KEY_SIZE - 1 + sizeof(Index)));
+	DestroyPool(&pool);
+
+	Destroy(&scanned);
+}
+
+BENCHMARK(BM_Table_ForEach)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->UseRealTime();
+
+#define BUILD_KEYS_COUNT (1ull << 20)
+
+/* distinct keys of KEY_SIZE - 1 bytes, with pointers and sizes as Build takes them. */
+static void GetBuildKeys(Byte ***keys, Count **sizes)
+{
+	static Boolean initialized = 0;
+	static Byte  **pointers;
+	static Count  *lengths;
+	if (!initialized) {
+		Byte *data = (Byte *)AllocateMemory(BUILD_KEYS_COUNT * KEY_SIZE);
+		pointers = (Byte **)AllocateMemory(BUILD_KEYS_COUNT * sizeof(Byte *));
+		lengths  = (Count *)AllocateMemory(BUILD_KEYS_COUNT * sizeof(Count));
+		for (Count i = 0; i < BUILD_KEYS_COUNT; ++i) {
+			Byte *key = data + i * KEY_SIZE;
+			Copy(key, GetKeys() + (i % KEYS_COUNT) * KEY_SIZE, KEY_SIZE);
+			*(Index *)key = i;
+			pointers[i] = key;
+			lengths[i]  = KEY_SIZE - 1;
+		}
+		initialized = 1;
+	}
+	*keys  = pointers;
+	*sizes = lengths;
+}
+
+/* builds of BUILD_KEYS_COUNT keys by the number of threads, against the
+   sequential insert loop below. */
+static void BM_Table_Build(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+
+	ThreadPool pool = {};
+	pool.threadscnt = state.range(0);
+	InitializePool(&pool);
+	for (auto _ : state) {
+		Table built = {};
+		built.quantity = BUILD_KEYS_COUNT >> 3;
+		Initialize(&built);
+		Assert(Build(&built, &pool, keys, sizes, 0, BUILD_KEYS_COUNT));
+		Destroy(&built);
+	}
+	state.SetItemsProcessed(state.iterations() * BUILD_KEYS_COUNT);
+	DestroyPool(&pool);
+}
+
+BENCHMARK(BM_Table_Build)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_Table_Insert(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+
+	for (auto _ : state) {
+		Table built = {};
+		built.quantity = BUILD_KEYS_COUNT >> 3;
+		Initialize(&built);
+		for (Count i = 0; i < BUILD_KEYS_COUNT; ++i)
+			*Fetch(keys[i], sizes[i], &built) = i;
+		Destroy(&built);
+	}
+	state.SetItemsProcessed(state.iterations() * BUILD_KEYS_COUNT);
+}
+
+BENCHMARK(BM_Table_Insert)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/* lookups on a live table and on its frozen copy, with the bytes per key each
+   holds; range 0 is the number of keys, up to BUILD_KEYS_COUNT. */
+static void FillLookupTable(Table *live, Count keyscnt)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	live->quantity = keyscnt >> 3 ? keyscnt >> 3 : 1;
+	Initialize(live);
+	for (Count i = 0; i < keyscnt; ++i)
+		*Fetch(keys[i], sizes[i], live) = i;
+}
+
+static void BM_Table_Live(benchmark::State &state)
+{
+	Count keyscnt = state.range(0);
+	Table live = {};
+	FillLookupTable(&live, keyscnt);
+
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < keyscnt ? i + 1 : 0;
+		benchmark::DoNotOptimize(Fetch(keys[i], sizes[i], &live));
+	}
+	Size commission = 0;
+	for (Count r = 0; r < live.quantity; ++r)
+		commission += ((TableRow *)(live.address + r * live.width))->commission;
+	state.counters["bytes_per_key"] = (double)commission / keyscnt;
+
+	Destroy(&live);
+}
+
+BENCHMARK(BM_Table_Live)->Arg(KEYS_COUNT)->Arg(1 << 16)->Arg(BUILD_KEYS_COUNT);
+
+/* hits on a frozen table of range(0) build keys, or if range(1) is 1 misses
+   on those keys cut short by a byte. */
+static void BM_Table_Frozen(benchmark::State &state)
+{
+	Count keyscnt = state.range(0);
+	Table live = {};
+	FillLookupTable(&live, keyscnt);
+	FrozenTable frozen = {};
+	Assert(Freeze(&live, &frozen));
+	Destroy(&live);
+
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < keyscnt ? i + 1 : 0;
+		benchmark::DoNotOptimize(FetchFrozen(keys[i], sizes[i] - state.range(1), &frozen));
+	}
+	state.counters["bytes_per_key"] = (double)frozen.size / keyscnt;
+
+	DestroyFrozen(&frozen);
+}
+
+BENCHMARK(BM_Table_Frozen)->ArgsProduct({{KEYS_COUNT, 1 << 16, BUILD_KEYS_COUNT}, {0, 1}});
+
+/* a warm start from a snapshot of the same keys, against the insert loop
+   above: the load and a lookup of every key. */
+static void BM_Table_Load(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+
+	const char *path = "BM_Table_Load.snapshot";
+	Table saved = {};
+	FillLookupTable(&saved, BUILD_KEYS_COUNT);
+	Assert(Save(&saved, path));
+	Destroy(&saved);
+
+	for (auto _ : state) {
+		Table loaded = {};
+		Assert(Load(&loaded, path, state.range(0)));
+		for (Count i = 0; i < BUILD_KEYS_COUNT; ++i)
+			benchmark::DoNotOptimize(Fetch(keys[i], sizes[i], &loaded));
+		Destroy(&loaded);
+	}
+	state.SetItemsProcessed(state.iterations() * BUILD_KEYS_COUNT);
+	DeleteFileA(path);
+}
+
+BENCHMARK(BM_Table_Load)->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/* lookups of absent keys in a sealed table of MISS_ROWS_COUNT rows holding
+   range(0) keys each; range(1) of 0 saturates every row filter, which scans
+   the rows as they were scanned before filters. */
+#define MISS_ROWS_COUNT (1ll << 10)
+
+static void BM_Table_Miss(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+
+	Count keyscnt = state.range(0) * MISS_ROWS_COUNT;
+	Table sealed = {};
+	sealed.quantity  = MISS_ROWS_COUNT;
+	sealed.tolerance = -1;
+	Initialize(&sealed);
+	for (Count i = 0; i < keyscnt; ++i)
+		*Fetch(keys[i], sizes[i], &sealed) = i;
+	if (!state.range(1))
+		for (Count r = 0; r < sealed.quantity; ++r)
+			((TableRow *)(sealed.address + r * sealed.width))->filter = ~0u;
+	sealed.sealed = 1;
+
+	Byte **misses    = keys + keyscnt;
+	Count *missessz  = sizes + keyscnt;
+	Count  missescnt = BUILD_KEYS_COUNT - keyscnt;
+	Index  i = 0;
+	for (auto _ : state) {
+		i = i + 1 < missescnt ? i + 1 : 0;
+		benchmark::DoNotOptimize(Fetch(misses[i], missessz[i], &sealed));
+	}
+	Count rejected = 0;
+	for (Count j = 0; j < missescnt; ++j) {
+		U64 strhash = HashKey(&sealed, misses[j], missessz[j]);
+		rejected += !TestFilter(GetRow(strhash, &sealed), GetFilterBits(strhash));
+	}
+	state.counters["rejected"] = (double)rejected / missescnt;
+
+	Destroy(&sealed);
+}
+
+BENCHMARK(BM_Table_Miss)->ArgsProduct({{1, 2, 4, 8, 16, 32, 64}, {0, 1}});
+
+/* a key set of the even build keys, looked up with every build key in turn;
+   range(0) picks wide fingerprints. compare bytes_per_key to BM_Table_Live. */
+static void BM_Table_Set(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+
+	KeySet set = {};
+	set.wide = state.range(0);
+	InitializeSet(&set);
+	for (Count i = 0; i < BUILD_KEYS_COUNT; i += 2)
+		Assert(!Mark(keys[i], sizes[i], &set));
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < BUILD_KEYS_COUNT ? i + 1 : 0;
+		benchmark::DoNotOptimize(Marked(keys[i], sizes[i], &set));
+	}
+	Count confused = 0;
+	for (Count j = 1; j < BUILD_KEYS_COUNT; j += 2) confused += Marked(keys[j], sizes[j], &set);
+	state.counters["bytes_per_key"]   = (double)(set.quantity * SET_ROW_SIZE) / set.population;
+	state.counters["false_positives"] = confused;
+
+	DestroySet(&set);
+}
+
+BENCHMARK(BM_Table_Set)->Arg(0)->Arg(1);
+
+/* lookups of the first range(0) bytes of COMPACT_KEYS_COUNT build keys, in a
+   Table and, if range(1), in a CompactTable, with rows of COMPACT_ROW_KEYS
+   keys; bytes_per_key counts record bytes, without row headers. */
+#define COMPACT_KEYS_COUNT (1ll << 16)
+#define COMPACT_ROW_KEYS   (1ll << 6)
+
+static void BM_Table_Compact(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Count keysz = state.range(0);
+
+	CompactTable compact = {};
+	Table       *table   = &compact.table;
+	table->quantity = COMPACT_KEYS_COUNT / COMPACT_ROW_KEYS;
+	Initialize(table);
+	for (Count i = 0; i < COMPACT_KEYS_COUNT; ++i) {
+		if (state.range(1)) Assert(StoreCompact(keys[i], keysz, (U32)i, &compact));
+		else                *Fetch(keys[i], keysz, table) = i;
+	}
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < COMPACT_KEYS_COUNT ? i + 1 : 0;
+		if (state.range(1)) {
+			U32 value;
+			benchmark::DoNotOptimize(FindCompact(keys[i], keysz, &value, &compact));
+		} else
+			benchmark::DoNotOptimize(Fetch(keys[i], keysz, table));
+	}
+	Size extent = 0;
+	for (Count r = 0; r < table->quantity; ++r)
+		extent += GaugeRow((TableRow *)(table->address + r * table->width)) - sizeof(TableRow);
+	state.counters["bytes_per_key"] = (double)extent / COMPACT_KEYS_COUNT;
+
+	Destroy(table);
+}
+
+BENCHMARK(BM_Table_Compact)->ArgsProduct({{10, 31}, {0, 1}});
+
+/* lookups of short keys in rows where every fourth key is range(0) bytes
+   long, kept in blobs or, if range(1) is 0, inline. */
+#define LONG_ROWS_COUNT (1ll << 10)
+#define LONG_KEYS_COUNT (1ll << 14)
+
+static void BM_Table_Long(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Count longsz = state.range(0);
+	Byte *buffer = (Byte *)AllocateMemory(AlignForwards(longsz, GetPageSize()));
+	Fill(buffer, 'L', longsz);
+
+	Table table = {};
+	table.quantity  = LONG_ROWS_COUNT;
+	table.threshold = state.range(1) ? 0 : -1;
+	Initialize(&table);
+	for (Count i = 0; i < LONG_KEYS_COUNT; ++i) {
+		*Fetch(keys[i], sizes[i], &table) = i;
+		if (i & 3) continue;
+		*(Index *)buffer = i;
+		*Fetch(buffer, longsz, &table) = i;
+	}
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < LONG_KEYS_COUNT ? i + 1 : 0;
+		benchmark::DoNotOptimize(Fetch(keys[i], sizes[i], &table));
+	}
+
+	Destroy(&table);
+	ReleaseMemory(buffer);
+}
+
+BENCHMARK(BM_Table_Long)->ArgsProduct({{1 << 9, 1 << 12}, {0, 1}});
+
+/* hashes of 32 build keys cut to range(0) bytes a step, with HashBatch and,
+   if range(1) is 0, with Hash one key at a time. */
+static void BM_HashBatch(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Count lengths[32];
+	U64   hashes[32];
+	U64   seed = Random();
+	for (Count j = 0; j < 32; ++j) lengths[j] = state.range(0);
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 64 <= KEYS_COUNT ? i + 32 : 0;
+		if (state.range(1))
+			HashBatch(keys + i, lengths, 32, TableHash_XXH3, seed, hashes);
+		else
+			for (Count j = 0; j < 32; ++j) hashes[j] = HashXXH3(keys[i + j], lengths[j], seed);
+		benchmark::DoNotOptimize(hashes);
+	}
+	state.SetItemsProcessed(state.iterations() * 32);
+}
 
-Index *Fetch(Byte *str, Count strsz, Table *table)
+BENCHMARK(BM_HashBatch)->ArgsProduct({{8, 16, 31, 64, 128}, {0, 1}});
+
+/* lookups of present keys in the table of BM_Table_Live, in batches of 32
+   through FindBatch, or one by one through Fetch if range(1) is 0. */
+static void BM_Table_FindBatch(benchmark::State &state)
 {
-	U64       hash      = Hash(str, strsz) & (table->quantity - 1);
-	Address   beginning = table->address + (hash << _tzcnt_u64(table->width));
-	TableRow *row       = (TableRow *)beginning;
-	TableKey *key       = row->keys;
-	Size      addition;
+	Count keyscnt = state.range(0);
+	Table live = {};
+	FillLookupTable(&live, keyscnt);
 
-	for (;;) {
-		if (key->size) {
-			if (key->size == strsz && !Test(key->data, str, strsz))
-				goto success;
-			else
-				key = GetNextKey(key);
-		} else
-			goto failure;
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Index *indices[32];
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 64 <= keyscnt ? i + 32 : 0;
+		if (state.range(1))
+			FindBatch(keys + i, sizes + i, 32, indices, &live);
+		else
+			for (Count j = 0; j < 32; ++j) indices[j] = Fetch(keys[i + j], sizes[i + j], &live);
+		benchmark::DoNotOptimize(indices);
 	}
+	state.SetItemsProcessed(state.iterations() * 32);
 
-failure:
-	//if (mode != TableMode_Insert) return 0;
-	addition = strsz + GetForwardAligner((Address)key + sizeof(TableKey) + strsz, alignof(Index)) + sizeof(Index) + sizeof(TableKey);
-	if (row->extent + addition + sizeof(TableKey) > row->commission) {
-		Size commission = AlignForwards(addition, table->granularity);
-		if (row->commission + commission > table->width) return 0;
-		CommitMemory((void *)((Address)row + row->commission), commission);
-		row->commission += commission;
+	Destroy(&live);
+}
+
+BENCHMARK(BM_Table_FindBatch)->ArgsProduct({{KEYS_COUNT, 1 << 16}, {0, 1}});
+
+/* each hash a table may pick on 32 build keys cut to
+   range(0) bytes a step. build keys begin with their ordinal, so up to 8
+   bytes they are integers. */
+template <U64 (*H)(const void *, Size, U64)>
+static void BM_Hash(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Count keysz = state.range(0);
+	U64   seed  = Random();
+	U64   hashes[32];
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 64 <= KEYS_COUNT ? i + 32 : 0;
+		for (Count j = 0; j < 32; ++j) hashes[j] = H(keys[i + j], keysz, seed);
+		benchmark::DoNotOptimize(hashes);
 	}
-	row->extent += addition;
-	key->size = strsz;
-	Copy(key->data, str, strsz);
-success:
-	Index *index = GetKeyIndex(key);
-	return index;
+	state.SetItemsProcessed(state.iterations() * 32);
 }
 
-/******************************************/
+BENCHMARK_TEMPLATE(BM_Hash, HashXXH3)->ArgsProduct({{4, 8, 16, 31, 64, 256}});
+BENCHMARK_TEMPLATE(BM_Hash, HashCRC32C)->ArgsProduct({{4, 8, 16, 31, 64, 256}});
+BENCHMARK_TEMPLATE(BM_Hash, HashMultiply)->ArgsProduct({{4, 8, 16, 31, 64, 256}});
 
-static inline U64 Random(void)
+/* the spread of all build keys of range(0) bytes over rows of 8 keys on
+   average, picked through Scatter as the tables pick them or, if range(1) is
+   1, by the top bits of the bare hash, where the row filters take theirs:
+   the longest row, and the chi-square statistic of the rows over its degrees
+   of freedom, about 1 for an even spread. */
+template <U64 (*H)(const void *, Size, U64)>
+static void BM_Hash_Spread(benchmark::State &state)
 {
-	U64 random;
-	while (!_rdrand64_step(&random));
-	return random;
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Count  keysz   = state.range(0);
+	Count  rowscnt = BUILD_KEYS_COUNT >> 3;
+	Count *rows    = (Count *)AllocateMemory(rowscnt * sizeof(Count));
+	U64    seed    = Random();
+
+	for (auto _ : state) {
+		Fill(rows, 0, rowscnt * sizeof(Count));
+		for (Count i = 0; i < BUILD_KEYS_COUNT; ++i) {
+			U64 strhash = H(keys[i], keysz, seed);
+			++rows[state.range(1) ? strhash >> (64 - _tzcnt_u64(rowscnt)) : Scatter(strhash, seed) & (rowscnt - 1)];
+		}
+		benchmark::DoNotOptimize(rows);
+	}
+
+	Count  longest   = 0;
+	double chisquare = 0;
+	for (Count r = 0; r < rowscnt; ++r) {
+		if (rows[r] > longest) longest = rows[r];
+		chisquare += (rows[r] - 8.0) * (rows[r] - 8.0) / 8;
+	}
+	state.counters["max_row"]    = (double)longest;
+	state.counters["chi_square"] = chisquare / (rowscnt - 1);
+	state.SetItemsProcessed(state.iterations() * BUILD_KEYS_COUNT);
+	ReleaseMemory(rows);
 }
 
-static inline Size GaugeString(Byte *str)
+BENCHMARK_TEMPLATE(BM_Hash_Spread, HashXXH3)->ArgsProduct({{4, 8, 31}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Hash_Spread, HashCRC32C)->ArgsProduct({{4, 8, 31}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Hash_Spread, HashMultiply)->ArgsProduct({{4, 8, 31}, {0, 1}});
+
+/* hits through Fetch on a table of each hash, of range(1) build keys of
+   range(0) bytes, 8 to a row; through Fetch<H> if range(2) is 1. */
+template <TableHash H>
+static void BM_Table_Hash(benchmark::State &state)
 {
-	return __builtin_strlen(str);
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Count keysz   = state.range(0);
+	Count keyscnt = state.range(1);
+
+	Table table = {};
+	table.quantity = keyscnt >> 3;
+	table.hash     = H;
+	Initialize(&table);
+	for (Count i = 0; i < keyscnt; ++i)
+		*Fetch(keys[i], keysz, &table) = i;
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < keyscnt ? i + 1 : 0;
+		if (state.range(2)) benchmark::DoNotOptimize(Fetch<H>(keys[i], keysz, &table));
+		else                benchmark::DoNotOptimize(Fetch(keys[i], keysz, &table));
+	}
+
+	Destroy(&table);
 }
 
-Byte *GetKeys(void)
+BENCHMARK_TEMPLATE(BM_Table_Hash, TableHash_XXH3)->ArgsProduct({{8, 31}, {KEYS_COUNT, 1 << 16}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Table_Hash, TableHash_CRC32C)->ArgsProduct({{8, 31}, {KEYS_COUNT, 1 << 16}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Table_Hash, TableHash_Multiply)->ArgsProduct({{8, 31}, {KEYS_COUNT, 1 << 16}, {0, 1}});
+
+/* hits on 64 keys of range(0) bytes, 8 to a row, on a table of a word hash:
+   through Fetch<H>, which hashes and compares keys up to SHORT_KEY_SIZE from
+   one register, or if range(1) is 0 through HashKey<H> and FetchHashed. */
+template <TableHash H>
+static void BM_Table_Short(benchmark::State &state)
 {
-	static Boolean initialized = 0;
-	static Byte keys[KEYS_COUNT][KEY_SIZE];
-	if (!initialized) {
-		Byte chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_0123456789";
-		Size charscnt = COUNTOF(chars) - 1;
-		for (Count i = 0; i < KEYS_COUNT; ++i) {
-			Byte *key = keys[i];
-			Count keysz = KEY_SIZE;
-			for (Count j = 0; j < keysz; ++j)
-				key[j] = chars[Random() % charscnt];
-			if (keysz == KEY_SIZE) --keysz;
-			key[keysz] = 0;
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	Count keysz = state.range(0);
+
+	Table table = {};
+	table.quantity = 1 << 3;
+	table.hash     = H;
+	Initialize(&table);
+	for (Count i = 0; i < 64; ++i)
+		*Fetch<H>(keys[i], keysz, &table) = i;
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = (i + 1) & 63;
+		if (state.range(1)) benchmark::DoNotOptimize(Fetch<H>(keys[i], keysz, &table));
+		else                benchmark::DoNotOptimize(FetchHashed(keys[i], keysz, HashKey<H>(&table, keys[i], keysz), &table));
+	}
+
+	Destroy(&table);
+}
+
+BENCHMARK_TEMPLATE(BM_Table_Short, TableHash_CRC32C)->ArgsProduct({{8, 16, 24, 32, 48, 64}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Table_Short, TableHash_Multiply)->ArgsProduct({{8, 16, 24, 32, 48, 64}, {0, 1}});
+
+/* compares of two equal keys of range(0) bytes, which read every byte, with
+   Test and with memcmp. */
+static void BM_Test(benchmark::State &state)
+{
+	Byte *keys = (Byte *)AllocateMemory(2 * AlignForwards(state.range(0) + 1, GetPageSize()));
+	Byte *left = keys, *right = keys + AlignForwards(state.range(0) + 1, GetPageSize());
+	for (Count i = 0; i < state.range(0); ++i) left[i] = right[i] = (Byte)Random();
+	Size size = state.range(0);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(size);
+		benchmark::DoNotOptimize(Test(left, right, size));
+	}
+	ReleaseMemory(keys);
+}
+
+static void BM_memcmp(benchmark::State &state)
+{
+	Byte *keys = (Byte *)AllocateMemory(2 * AlignForwards(state.range(0) + 1, GetPageSize()));
+	Byte *left = keys, *right = keys + AlignForwards(state.range(0) + 1, GetPageSize());
+	for (Count i = 0; i < state.range(0); ++i) left[i] = right[i] = (Byte)Random();
+	Size size = state.range(0);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(size);
+		benchmark::DoNotOptimize(memcmp(left, right, size));
+	}
+	ReleaseMemory(keys);
+}
+
+BENCHMARK(BM_Test)->Arg(3)->Arg(7)->Arg(15)->Arg(31)->Arg(63)->Arg(127)->Arg(255)->Arg(1023)->Arg(4095);
+BENCHMARK(BM_memcmp)->Arg(3)->Arg(7)->Arg(15)->Arg(31)->Arg(63)->Arg(127)->Arg(255)->Arg(1023)->Arg(4095);
+
+/* random lookups on a file-backed table of range(0) times BACKED_BUDGET bytes
+   of keys, with the working set held to BACKED_BUDGET by a hard limit. rows
+   are sized to about a page so that a lookup faults in a single page. */
+#define BACKED_BUDGET (1ll << 26)
+
+static void BM_Table_Backed(benchmark::State &state)
+{
+	Size  recordsz = sizeof(TableKey) + KEY_SIZE + sizeof(Index);
+	Count keyscnt  = state.range(0) * BACKED_BUDGET / recordsz;
+
+	Table backed = {};
+	backed.backing     = ".";
+	backed.quantity    = 1;
+	while (backed.quantity * (Count)(GetPageSize() / recordsz / 2) < keyscnt) backed.quantity <<= 1;
+	backed.reservation = backed.quantity * GetPageSize() * 2;
+	Initialize(&backed);
+
+	Byte key[KEY_SIZE];
+	Copy(key, GetKeys(), KEY_SIZE);
+	for (Count i = 0; i < keyscnt; ++i) {
+		*(Index *)key = i;
+		*Fetch(key, KEY_SIZE, &backed) = i;
+	}
+
+	SIZE_T minimum, maximum;
+	DWORD  flags;
+	GetProcessWorkingSetSizeEx(GetCurrentProcess(), &minimum, &maximum, &flags);
+	SetProcessWorkingSetSizeEx(GetCurrentProcess(), 1 << 20, BACKED_BUDGET, QUOTA_LIMITS_HARDWS_MIN_DISABLE | QUOTA_LIMITS_HARDWS_MAX_ENABLE);
+	U64 i = 0;
+	for (auto _ : state) {
+		*(Index *)key = Scatter(++i, 0) % keyscnt;
+		benchmark::DoNotOptimize(Fetch(key, KEY_SIZE, &backed));
+	}
+	SetProcessWorkingSetSizeEx(GetCurrentProcess(), minimum, maximum, flags);
+	state.counters["keys"] = (double)keyscnt;
+
+	Destroy(&backed);
+}
+
+BENCHMARK(BM_Table_Backed)->Arg(1)->Arg(2)->Arg(4);
+
+/* one checkpoint of a table of BUILD_KEYS_COUNT keys after range(0) writes
+   to random keys, with the bytes each checkpoint appends. */
+static void BM_Table_Checkpoint(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+
+	const char *path = "BM_Table_Checkpoint.checkpoint";
+	Table table = {};
+	FillLookupTable(&table, BUILD_KEYS_COUNT);
+	DeleteFileA(path);
+	Assert(Checkpoint(&table, path));
+
+	Count writescnt = state.range(0);
+	Size  written   = 0;
+	U64   i         = 0;
+	for (auto _ : state) {
+		state.PauseTiming();
+		for (Count j = 0; j < writescnt; ++j) {
+			Count k = Scatter(++i, 0) % BUILD_KEYS_COUNT;
+			Store(keys[k], sizes[k], j, &table);
 		}
-		initialized = 1;
+		DeleteFileA(path);
+		state.ResumeTiming();
+
+		Assert(Checkpoint(&table, path));
+
+		state.PauseTiming();
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		LARGE_INTEGER filesz;
+		GetFileSizeEx(file, &filesz);
+		CloseHandle(file);
+		written += filesz.QuadPart;
+		state.ResumeTiming();
 	}
-	return &keys[0][0];
+	state.counters["bytes_per_checkpoint"] = (double)written / state.iterations();
+
+	DeleteFileA(path);
+	Destroy(&table);
 }
 
-Size *GetKeySizes(void)
+BENCHMARK(BM_Table_Checkpoint)->Arg(0)->Arg(1 << 8)->Arg(1 << 12)->Arg(1 << 16)->Arg(BUILD_KEYS_COUNT)->Unit(benchmark::kMillisecond);
+
+/* writer latency while a snapshot of BUILD_KEYS_COUNT keys is taken: with
+   range(0) at 0, Save stops the writer for the whole write; at 1, BeginSave
+   lets it run on and copy rows as it first changes them. each iteration is
+   one save overlapped with SAVE_WRITES_COUNT writes to random keys. */
+#define SAVE_WRITES_COUNT (1ll << 16)
+
+/* the bytes of the file at `path`, mapped read-only, or 0. */
+static Byte *MapFile(const char *path, Size *size)
 {
-	static Boolean initialized = 0;
-	static Size sizes[KEYS_COUNT];
-	if (!initialized) {
-		Byte *keys = GetKeys();
-		for (Count i = 0; i < KEYS_COUNT; ++i)
-			sizes[i] = strlen(keys + i * KEY_SIZE);
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE) return 0;
+	LARGE_INTEGER filesz;
+	HANDLE mapping = GetFileSizeEx(file, &filesz) ? CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0) : 0;
+	CloseHandle(file);
+	if (!mapping) return 0;
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	*size = filesz.QuadPart;
+	return (Byte *)view;
+}
+
+/* a snapshot of rows of mixed lengths taken by BeginSave, against the one
+   Save writes: rows folded one after another in the same buffer must come out
+   byte for byte alike. */
+static void CheckImage(Byte **keys)
+{
+	Table table = {};
+	table.quantity = 1 << 6;
+	Initialize(&table);
+	for (Count i = 0; i < 3000; ++i)
+		*Fetch(keys[i], 1 + i % 60, &table) = i;
+
+	TableImage image = {};
+	Assert(Save(&table, "CheckImage.saved"));
+	Assert(BeginSave(&table, &image, "CheckImage.image"));
+	Assert(EndSave(&image));
+	Size  savedsz, imagesz;
+	Byte *saved = MapFile("CheckImage.saved", &savedsz);
+	Byte *taken = MapFile("CheckImage.image", &imagesz);
+	Assert(saved && taken && savedsz == imagesz && !Test(saved, taken, savedsz));
+	UnmapViewOfFile(saved);
+	UnmapViewOfFile(taken);
+	DeleteFileA("CheckImage.saved");
+	DeleteFileA("CheckImage.image");
+	Destroy(&table);
+}
+
+static void BM_Table_Save(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+	CheckImage(keys);
+
+	const char *path = "BM_Table_Save.snapshot";
+	Table table = {};
+	FillLookupTable(&table, BUILD_KEYS_COUNT);
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	Count stall = 0;
+	U64   i     = 0;
+	for (auto _ : state) {
+		TableImage image = {};
+		Count beginning = Clock();
+		if (state.range(0)) Assert(BeginSave(&table, &image, path));
+		else                Assert(Save(&table, path));
+		Count latency = Clock() - beginning;
+		if (latency > stall) stall = latency;
+		for (Count j = 0; j < SAVE_WRITES_COUNT; ++j) {
+			Count k = Scatter(++i, 0) % BUILD_KEYS_COUNT;
+			beginning = Clock();
+			Store(keys[k], sizes[k], j, &table);
+			latency = Clock() - beginning;
+			if (latency > stall) stall = latency;
+		}
+		if (state.range(0)) Assert(EndSave(&image));
 	}
-	return sizes;
+	state.counters["max_stall_us"] = (double)stall * 1000000 / frequency.QuadPart;
+
+	DeleteFileA(path);
+	Destroy(&table);
 }
 
-#define Clock() ({ LARGE_INTEGER x; QueryPerformanceCounter(&x); x.QuadPart; })
+BENCHMARK(BM_Table_Save)->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
 
-Table0 table0;
-Table  table;
-std::unordered_map<std::string_view, Index> umap;
+/* memory of range(0) reader processes attached to one shared table of
+   BUILD_KEYS_COUNT keys, each having looked up every key; the readers are
+   this program run with --attach. */
+#define SHARED_NAME "Local\\BM_Table_Shared"
 
-static void BM_Table0(benchmark::State &state)
+static int RunAttached(const char *name)
 {
-	Initialize0(&table0);
+	HANDLE ready = OpenSemaphoreA(SEMAPHORE_ALL_ACCESS, 0, SHARED_NAME ".ready");
+	HANDLE done  = OpenSemaphoreA(SEMAPHORE_ALL_ACCESS, 0, SHARED_NAME ".done");
+	SharedTable shared = {};
+	Boolean attached = AttachShared(&shared, name, 0);
+
+	/* keys are random per process, so the reader looks up the ones it finds
+	   in the table. */
+	if (attached) {
+		TableCursor cursor;
+		Begin(&cursor, &shared.share->table);
+		for (Index *index; (index = Advance(&cursor));) {
+			Index value;
+			Assert(FindShared(cursor.key, cursor.keysz, &value, &shared) && value == *index);
+		}
+	}
+	ReleaseSemaphore(ready, 1, 0);
+	WaitForSingleObject(done, INFINITE);
+	CloseHandle(ready);
+	CloseHandle(done);
+	if (attached) DetachShared(&shared);
+	return !attached;
+}
+
+static void BM_Table_Shared(benchmark::State &state)
+{
+	Byte **keys;
+	Count *sizes;
+	GetBuildKeys(&keys, &sizes);
+
+	Count processescnt = state.range(0);
+	char  image[MAX_PATH];
+	char  command[MAX_PATH * 2];
+	GetModuleFileNameA(0, image, MAX_PATH);
+	snprintf(command, sizeof(command), "\"%s\" --attach %s", image, SHARED_NAME);
+
+	for (auto _ : state) {
+		SharedTable shared = {};
+		Assert(CreateShared(&shared, SHARED_NAME, BUILD_KEYS_COUNT >> 3, 0, TableHash_XXH3));
+		for (Count i = 0; i < BUILD_KEYS_COUNT; ++i)
+			Assert(StoreShared(keys[i], sizes[i], i, &shared));
+		Table *table = &shared.share->table;
+		Size   tablesz = GetShareHeaderSize(table->quantity);
+		for (Count r = 0; r < table->quantity; ++r)
+			tablesz += ((TableRow *)(table->address + r * table->width))->commission;
+
+		HANDLE ready = CreateSemaphoreA(0, 0, (LONG)processescnt, SHARED_NAME ".ready");
+		HANDLE done  = CreateSemaphoreA(0, 0, (LONG)processescnt, SHARED_NAME ".done");
+		PROCESS_INFORMATION processes[MAX_THREADS];
+		for (Count p = 0; p < processescnt; ++p) {
+			STARTUPINFOA startup = {sizeof(startup)};
+			Assert(CreateProcessA(image, command, 0, 0, 0, 0, 0, 0, &startup, &processes[p]));
+		}
+		for (Count p = 0; p < processescnt; ++p) WaitForSingleObject(ready, INFINITE);
+
+		Size privatesz = 0, workingsz = 0;
+		for (Count p = 0; p < processescnt; ++p) {
+			PROCESS_MEMORY_COUNTERS_EX counters = {sizeof(counters)};
+			GetProcessMemoryInfo(processes[p].hProcess, (PROCESS_MEMORY_COUNTERS *)&counters, sizeof(counters));
+			privatesz += counters.PrivateUsage;
+			workingsz += counters.WorkingSetSize;
+		}
+		ReleaseSemaphore(done, (LONG)processescnt, 0);
+		for (Count p = 0; p < processescnt; ++p) {
+			WaitForSingleObject(processes[p].hProcess, INFINITE);
+			CloseHandle(processes[p].hProcess);
+			CloseHandle(processes[p].hThread);
+		}
+		CloseHandle(ready);
+		CloseHandle(done);
+		DetachShared(&shared);
+
+		state.counters["table_mb"]   = (double)tablesz / (1 << 20);
+		state.counters["private_mb"] = (double)privatesz / processescnt / (1 << 20);
+		state.counters["working_mb"] = (double)workingsz / processescnt / (1 << 20);
+	}
+}
+
+BENCHMARK(BM_Table_Shared)->Arg(1)->Arg(4)->Arg(16)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+static constexpr StaticKey keywords[] = {
+	MakeStaticKey("alignas"), MakeStaticKey("alignof"), MakeStaticKey("asm"),
+	MakeStaticKey("auto"), MakeStaticKey("bool"), MakeStaticKey("break"),
+	MakeStaticKey("case"), MakeStaticKey("catch"), MakeStaticKey("char"),
+	MakeStaticKey("class"), MakeStaticKey("const"), MakeStaticKey("constexpr"),
+	MakeStaticKey("const_cast"), MakeStaticKey("continue"),
+	MakeStaticKey("decltype"), MakeStaticKey("default"), MakeStaticKey("delete"),
+	MakeStaticKey("do"), MakeStaticKey("double"), MakeStaticKey("dynamic_cast"),
+	MakeStaticKey("else"), MakeStaticKey("enum"), MakeStaticKey("explicit"),
+	MakeStaticKey("export"), MakeStaticKey("extern"), MakeStaticKey("false"),
+	MakeStaticKey("float"), MakeStaticKey("for"), MakeStaticKey("friend"),
+	MakeStaticKey("goto"), MakeStaticKey("if"), MakeStaticKey("inline"),
+	MakeStaticKey("int"), MakeStaticKey("long"), MakeStaticKey("mutable"),
+	MakeStaticKey("namespace"), MakeStaticKey("new"), MakeStaticKey("noexcept"),
+	MakeStaticKey("nullptr"), MakeStaticKey("operator"), MakeStaticKey("private"),
+	MakeStaticKey("protected"), MakeStaticKey("public"),
+	MakeStaticKey("register"), MakeStaticKey("reinterpret_cast"),
+	MakeStaticKey("return"), MakeStaticKey("short"), MakeStaticKey("signed"),
+	MakeStaticKey("sizeof"), MakeStaticKey("static"),
+	MakeStaticKey("static_assert"), MakeStaticKey("static_cast"),
+	MakeStaticKey("struct"), MakeStaticKey("switch"), MakeStaticKey("template"),
+	MakeStaticKey("this"), MakeStaticKey("thread_local"), MakeStaticKey("throw"),
+	MakeStaticKey("true"), MakeStaticKey("try"), MakeStaticKey("typedef"),
+	MakeStaticKey("typeid"), MakeStaticKey("typename"), MakeStaticKey("union")
+};
+
+static constexpr auto keywordstable = MakeStaticTable(keywords);
+
+static void BM_Table_Static(benchmark::State &state)
+{
+	Count keywordscnt = sizeof(keywords) / sizeof(*keywords);
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < keywordscnt ? i + 1 : 0;
+		benchmark::DoNotOptimize(FetchStatic(keywordstable, keywords[i].data, keywords[i].size));
+	}
+}
+
+BENCHMARK(BM_Table_Static);
+
+static void BM_Table_Keywords(benchmark::State &state)
+{
+	Count keywordscnt = sizeof(keywords) / sizeof(*keywords);
+	Table lookup = {};
+	lookup.quantity = keywordscnt;
+	Initialize(&lookup);
+	for (Index i = 0; i < keywordscnt; ++i) *Fetch((Byte *)keywords[i].data, keywords[i].size, &lookup) = i;
+
+	Index i = 0;
+	for (auto _ : state) {
+		i = i + 1 < keywordscnt ? i + 1 : 0;
+		benchmark::DoNotOptimize(Fetch((Byte *)keywords[i].data, keywords[i].size, &lookup));
+	}
+
+	Destroy(&lookup);
+}
+
+BENCHMARK(BM_Table_Keywords);
+
+static void BM_Table0_Reset(benchmark::State &state)
+{
+	Table0 cycle = {};
+	Initialize0(&cycle);
 
 	Byte *keys  = GetKeys();
 	Size *sizes = GetKeySizes();
-	Index i = 0;
 	for (auto _ : state) {
-		i %= KEYS_COUNT;
-		Byte *key  = keys + i * KEY_SIZE;
-		Size  size = sizes[i];
-		benchmark::DoNotOptimize(Fetch0(key, size, &table0));
-		++i;
+		for (Index i = 0; i < KEYS_COUNT; ++i)
+			*Fetch0(keys + i * KEY_SIZE, sizes[i], &cycle) = i;
+		Reset0(&cycle);
 	}
+
+	Destroy0(&cycle);
 }
 
-BENCHMARK(BM_Table0);
+BENCHMARK(BM_Table0_Reset);
 
-static void BM_Table(benchmark::State &state)
+static void BM_Table0_Rebuild(benchmark::State &state)
 {
-	Initialize(&table);
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	for (auto _ : state) {
+		Table0 cycle = {};
+		Initialize0(&cycle);
+		for (Index i = 0; i < KEYS_COUNT; ++i)
+			*Fetch0(keys + i * KEY_SIZE, sizes[i], &cycle) = i;
+		Destroy0(&cycle);
+	}
+}
+
+BENCHMARK(BM_Table0_Rebuild);
+
+static void BM_Table_Reset(benchmark::State &state)
+{
+	Table cycle = {};
+	Initialize(&cycle);
+
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	for (auto _ : state) {
+		for (Index i = 0; i < KEYS_COUNT; ++i)
+			*Fetch(keys + i * KEY_SIZE, sizes[i], &cycle) = i;
+		Reset(&cycle);
+	}
+
+	Destroy(&cycle);
+}
+
+BENCHMARK(BM_Table_Reset);
+
+static void BM_Table_Rebuild(benchmark::State &state)
+{
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	for (auto _ : state) {
+		Table cycle = {};
+		Initialize(&cycle);
+		for (Index i = 0; i < KEYS_COUNT; ++i)
+			*Fetch(keys + i * KEY_SIZE, sizes[i], &cycle) = i;
+		Destroy(&cycle);
+	}
+}
+
+BENCHMARK(BM_Table_Rebuild);
+
+static void BM_TableArena(benchmark::State &state)
+{
+	TableArena arena = {};
+	InitializeArena(&arena);
+
+	Byte *keys  = GetKeys();
+	Size *sizes = GetKeySizes();
+	for (auto _ : state) {
+		Table carved = {};
+		carved.arena = &arena;
+		Initialize(&carved);
+		for (Index i = 0; i < KEYS_COUNT; ++i)
+			*Fetch(keys + i * KEY_SIZE, sizes[i], &carved) = i;
+		Destroy(&carved);
+	}
+
+	DestroyArena(&arena);
+}
+
+BENCHMARK(BM_TableArena);
+
+/* tables held at once, as with one table per session. */
+static void BM_TableArena_Sessions(benchmark::State &state)
+{
+	Count  sessionscnt = state.range(0);
+	Table *sessions    = (Table *)AllocateMemory(sessionscnt * sizeof(Table));
 
 	Byte *keys  = GetKeys();
 	Size *sizes = GetKeySizes();
+	for (auto _ : state) {
+		TableArena arena = {};
+		InitializeArena(&arena);
+		for (Count i = 0; i < sessionscnt; ++i) {
+			sessions[i] = {};
+			sessions[i].arena = &arena;
+			Initialize(&sessions[i]);
+			Index j = i % KEYS_COUNT;
+			*Fetch(keys + j * KEY_SIZE, sizes[j], &sessions[i]) = i;
+		}
+		state.counters["commission"] = (double)arena.commission;
+		DestroyArena(&arena);
+	}
+	state.SetItemsProcessed(state.iterations() * sessionscnt);
+
+	ReleaseMemory(sessions);
+}
+
+BENCHMARK(BM_TableArena_Sessions)->Arg(1 << 14)->Arg(1 << 16);
+
+#define SKEWED_KEYS_COUNT (1ull << 14)
+#define SKEWED_ROWS_COUNT (1ull << 2)
+#define SKEWED_SEED       (0x5EED)
+
+/* keys whose hashes under SKEWED_SEED all land in the first SKEWED_ROWS_COUNT
+   rows of a table of DEFAULT_QUANTITY rows. */
+Byte *GetSkewedKeys(void)
+{
+	static Boolean initialized = 0;
+	static Byte keys[SKEWED_KEYS_COUNT][KEY_SIZE];
+	if (!initialized) {
+		Byte chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_0123456789";
+		Size charscnt = COUNTOF(chars) - 1;
+		for (Count i = 0; i < SKEWED_KEYS_COUNT; ++i) {
+			Byte *key = keys[i];
+			do {
+				for (Count j = 0; j < KEY_SIZE - 1; ++j)
+					key[j] = chars[Random() % charscnt];
+			} while ((Scatter(HashXXH3(key, KEY_SIZE - 1, SKEWED_SEED), SKEWED_SEED) & (DEFAULT_QUANTITY - 1)) >= SKEWED_ROWS_COUNT);
+			key[KEY_SIZE - 1] = 0;
+		}
+		initialized = 1;
+	}
+	return &keys[0][0];
+}
+
+/* rows a single granule wide, so nearly every skewed key lands in overflow pages. */
+static void BM_Table_Skewed(benchmark::State &state)
+{
+	Table skewed = {};
+	skewed.reservation = DEFAULT_QUANTITY * DEFAULT_GRANULARITY;
+	skewed.seed        = SKEWED_SEED;
+	skewed.tolerance   = -1;
+	Initialize(&skewed);
+
+	Byte *keys = GetSkewedKeys();
+	for (Index i = 0; i < SKEWED_KEYS_COUNT; ++i)
+		*Fetch(keys + i * KEY_SIZE, KEY_SIZE - 1, &skewed) = i;
+
 	Index i = 0;
 	for (auto _ : state) {
-		i %= KEYS_COUNT;
-		Byte *key  = keys + i * KEY_SIZE;
-		Size  size = sizes[i];
-		benchmark::DoNotOptimize(Fetch(key, size, &table));
+		i %= SKEWED_KEYS_COUNT;
+		benchmark::DoNotOptimize(Fetch(keys + i * KEY_SIZE, KEY_SIZE - 1, &skewed));
 		++i;
 	}
+	state.counters["spillage"] = (double)skewed.spillage;
+
+	Destroy(&skewed);
 }
 
-BENCHMARK(BM_Table);
+BENCHMARK(BM_Table_Skewed);
+
+/* the skewed keys against a table whose seed leaked to the attacker; the
+   flooding guard is on (range 1) or off (range 0). */
+static void BM_Table_Flooded(benchmark::State &state)
+{
+	Byte *keys = GetSkewedKeys();
+
+	Table flooded = {};
+	flooded.seed      = SKEWED_SEED;
+	flooded.tolerance = state.range(0) ? DEFAULT_TOLERANCE : -1;
+	Initialize(&flooded);
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	Count beginning = Clock();
+	for (Index i = 0; i < SKEWED_KEYS_COUNT; ++i)
+		*Fetch(keys + i * KEY_SIZE, KEY_SIZE - 1, &flooded) = i;
+	Count ending = Clock();
+
+	Index i = 0;
+	for (auto _ : state) {
+		i %= SKEWED_KEYS_COUNT;
+		benchmark::DoNotOptimize(Fetch(keys + i * KEY_SIZE, KEY_SIZE - 1, &flooded));
+		++i;
+	}
+	state.counters["build_ms"] = (double)(ending - beginning) * 1000 / frequency.QuadPart;
+	state.counters["reseeded"] = flooded.seed != SKEWED_SEED;
+
+	Destroy(&flooded);
+}
+
+BENCHMARK(BM_Table_Flooded)->Arg(0)->Arg(1);
 
 static void BM_unorderd_map(benchmark::State &state)
 {
@@ -406,12 +4830,17 @@ BENCHMARK(BM_unorderd_map);
 
 int main(int argc, char *argv[])
 {
+	if (argc == 3 && !strcmp(argv[1], "--attach")) return RunAttached(argv[2]);
+
 	printf("KEY_SIZE           : %llu\n", KEY_SIZE);
 	printf("KEYS_COUNT         : %llu\n", KEYS_COUNT);
 	printf("DEFAULT_RESERVATION: %llu\n", DEFAULT_RESERVATION);
 	printf("DEFAULT_EXTENT     : %llu\n", DEFAULT_EXTENT);
 	printf("DEFAULT_QUANTITY   : %llu\n", DEFAULT_QUANTITY);
 	printf("DEFAULT_GRANULARITY: %llu\n", DEFAULT_GRANULARITY);
+	printf("DEFAULT_ARENA_RESERVATION: %llu\n", DEFAULT_ARENA_RESERVATION);
+	printf("DEFAULT_ARENA_GRANULARITY: %llu\n", DEFAULT_ARENA_GRANULARITY);
+	printf("DEFAULT_ARENA_QUANTITY   : %llu\n", DEFAULT_ARENA_QUANTITY);
 	
 	::benchmark::Initialize(&argc, argv);
 	::benchmark::RunSpecifiedBenchmarks();